@@ -0,0 +1,215 @@
+#include "bench_controller.h"
+
+#include <fstream>
+#include <chrono>
+#include <format>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "config.h"
+#include "platform.h"
+#include "render/frame_pool.h"
+#include "render/frame_encoder.h"
+
+#include <spdlog/spdlog.h>
+
+namespace {
+	// measures the wall clock time of given function and stores it as a phase of the result
+	template<typename TFunc>
+	bool Measure(TBench_Result& result, const std::string& phase, TFunc&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		const bool ok = func();
+		result.phases.push_back({ phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() });
+		return ok;
+	}
+
+	/*
+	 * Samples the resident memory of the process on a background thread - the peak the system reports only ever grows, so
+	 * it cannot tell the peak of a single case, when the cases run one after another in the same process
+	 */
+	class CMemory_Sampler {
+		private:
+			// sampling period
+			static constexpr std::chrono::milliseconds Period{ 5 };
+
+			std::atomic<bool> mStop{ false };
+			std::atomic<size_t> mPeak{ 0 };
+			std::thread mThread;
+
+			void Sample() {
+				const size_t current = Get_Current_Memory_Usage();
+				size_t peak = mPeak.load();
+				while (current > peak && !mPeak.compare_exchange_weak(peak, current)) {
+					//
+				}
+			}
+
+		public:
+			CMemory_Sampler() {
+				Sample();
+				mThread = std::thread([this] {
+					while (!mStop) {
+						Sample();
+						std::this_thread::sleep_for(Period);
+					}
+				});
+			}
+
+			~CMemory_Sampler() {
+				Stop();
+			}
+
+			// stops the sampling and retrieves the highest resident memory seen
+			size_t Stop() {
+				mStop = true;
+				if (mThread.joinable()) {
+					mThread.join();
+				}
+				Sample();
+				return mPeak;
+			}
+	};
+}
+
+bool CBench_Controller::Run_Case(const std::string& name, const TGenerator_Settings& settings, const std::filesystem::path& workDir, size_t jobs, bool stitch, TBench_Result& result) {
+
+	result.name = name;
+	result.settings = settings;
+
+	// every case starts from scratch, as if it was a separate run of the application
+	Reset_Global_State();
+
+	const auto inputFile = workDir / (name + ".vdef");
+	const auto outputDir = workDir / name;
+
+	std::error_code ec;
+	std::filesystem::create_directories(outputDir, ec);
+	if (ec) {
+		spdlog::error("Cannot create output directory {}: {}", outputDir.string(), ec.message());
+		return false;
+	}
+
+	{
+		const std::string source = CScene_Generator(settings).Generate();
+		result.inputBytes = source.size();
+
+		std::ofstream out(inputFile, std::ios::out | std::ios::binary);
+		out << source;
+		if (!out) {
+			spdlog::error("Cannot write generated input {}", inputFile.string());
+			return false;
+		}
+	}
+
+	// the generated source is released already, so the case starts with what the previous cases left behind
+	result.baseMemory = Get_Current_Memory_Usage();
+	CMemory_Sampler memory;
+
+	// the pipeline and stitching are measured separately, so ffmpeg must not run alongside the rendering
+	if (Initialize({ "VidGenX_bench", "--jobs", std::to_string(jobs), "--stitch-after", inputFile.string(), outputDir.string() }) != 0) {
+		return false;
+	}
+
+	result.ok = Measure(result, "parse_input", [this] { return Parse_Input_Files(); })
+		&& Measure(result, "parse_blocks", [this] { return Parse_Blocks(); })
+		&& Bench_Scene_Step(result)
+		&& Bench_Frames(result)
+		&& Measure(result, "pipeline", [this] { return Render_Scenes(); })
+		&& (!stitch || Measure(result, "stitch", [this] { return Stitch_Video(); }));
+
+	result.peakMemory = memory.Stop();
+
+	// the storage is counted once the scenes were prepared, so the draw lists of composites are included
+	TStorage_Usage usage;
+	for (auto& scene : Get_Scenes()) {
+		scene->Account_Storage(usage);
+	}
+	result.sceneEntities = usage.entities;
+	result.instanceMemory = usage.instanceBytes;
+	result.sharedMemory = usage.sharedBytes;
+
+	for (auto& ph : result.phases) {
+		if (ph.name == "parse_input" && ph.seconds > 0) {
+			result.parseThroughput = static_cast<double>(result.inputBytes) / (1024.0 * 1024.0) / ph.seconds;
+		}
+	}
+
+	return result.ok;
+}
+
+bool CBench_Controller::Bench_Scene_Step(TBench_Result& result) {
+
+	return Measure(result, "scene_step", [this, &result] {
+		result.frames = 0;
+
+		for (auto& scene : Get_Scenes()) {
+			if (!scene->Begin()) {
+				return false;
+			}
+
+			do {
+				result.frames++;
+			} while (scene->Next_Frame());
+		}
+
+		return true;
+	});
+}
+
+bool CBench_Controller::Bench_Frames(TBench_Result& result) {
+
+	const int width = static_cast<int>(sConfig.Get_Width());
+	const int height = static_cast<int>(sConfig.Get_Height());
+
+	CFrame_Buffer buffer(width, height);
+
+	auto encoder = CFrame_Encoder::Create(Get_Encoder_Settings());
+	std::vector<uint8_t> encoded;
+
+	CDamage_Region full(width, height);
+	full.Set_Full();
+
+	using clock = std::chrono::steady_clock;
+	clock::duration record{}, rasterize{}, encode{};
+
+	size_t frameIndex = 0;
+
+	for (auto& scene : Get_Scenes()) {
+		if (!scene->Begin()) {
+			return false;
+		}
+
+		do {
+			CFrame_Snapshot snapshot(frameIndex++);
+
+			auto t0 = clock::now();
+			scene->Render_Frame(snapshot);
+
+			// the pipeline redraws whole frames by default, so measure the same
+			snapshot.Set_Damage(full);
+
+			auto t1 = clock::now();
+			snapshot.Rasterize(buffer.Get_Context());
+			buffer.Sync();
+
+			auto t2 = clock::now();
+			if (!encoder->Encode(buffer.Get_Image(), encoded)) {
+				spdlog::error("Cannot encode frame {}", snapshot.Get_Frame_Index());
+				return false;
+			}
+
+			auto t3 = clock::now();
+
+			record += t1 - t0;
+			rasterize += t2 - t1;
+			encode += t3 - t2;
+		} while (scene->Next_Frame());
+	}
+
+	result.phases.push_back({ "record", std::chrono::duration<double>(record).count() });
+	result.phases.push_back({ "rasterize", std::chrono::duration<double>(rasterize).count() });
+	result.phases.push_back({ "encode", std::chrono::duration<double>(encode).count() });
+
+	return true;
+}
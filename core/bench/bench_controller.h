@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "controller.h"
+#include "scene_generator.h"
+
+/*
+ * Duration of a single benchmarked phase
+ */
+struct TBench_Phase {
+	std::string name;		// phase name
+	double seconds = 0;		// wall clock time spent in the phase
+};
+
+/*
+ * Result of a single benchmark case
+ */
+struct TBench_Result {
+	std::string name;						// case name
+	TGenerator_Settings settings;			// generated scene settings
+	size_t inputBytes = 0;					// size of the generated .vdef source
+	size_t frames = 0;						// number of frames of the video
+	std::vector<TBench_Phase> phases;		// measured phases in order of execution
+	double parseThroughput = 0;				// input parsing speed (MB/s)
+	size_t baseMemory = 0;					// resident memory of the process when the case started (bytes)
+	size_t peakMemory = 0;					// peak resident memory sampled while the case ran (bytes)
+	size_t sceneEntities = 0;				// number of entities in the built scenes
+	size_t instanceMemory = 0;				// storage owned by the scene entities themselves (bytes)
+	size_t sharedMemory = 0;				// storage shared among the scene entities, e.g. composite contents and draw lists (bytes)
+	bool ok = false;						// did all phases succeed?
+};
+
+/*
+ * Benchmark controller - runs the phases of the regular controller one by one and measures each of them
+ */
+class CBench_Controller : public CController {
+	protected:
+		// measures the scene stepping alone (no frames are recorded)
+		bool Bench_Scene_Step(TBench_Result& result);
+		// measures frame recording, rasterization and encoding on a single thread, so they may be told apart
+		bool Bench_Frames(TBench_Result& result);
+
+	public:
+		// runs a single benchmark case in given working directory
+		bool Run_Case(const std::string& name, const TGenerator_Settings& settings, const std::filesystem::path& workDir, size_t jobs, bool stitch, TBench_Result& result);
+};
@@ -0,0 +1,61 @@
+#include "bench_report.h"
+#include "json.h"
+
+#include <format>
+#include <algorithm>
+
+CBench_Report::CBench_Report(size_t jobs) : mJobs(jobs) {
+	//
+}
+
+void CBench_Report::Add(const TBench_Result& result) {
+	mResults.push_back(result);
+}
+
+bool CBench_Report::Is_Ok() const {
+	for (auto& res : mResults) {
+		if (!res.ok) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CBench_Report::Write(std::ostream& out) const {
+
+	out << "{\n";
+	out << std::format("  \"jobs\": {},\n", mJobs);
+	out << "  \"cases\": [\n";
+
+	for (size_t i = 0; i < mResults.size(); i++) {
+		auto& res = mResults[i];
+		auto& set = res.settings;
+
+		out << "    {\n";
+		out << std::format("      \"name\": \"{}\",\n", Escape_JSON(res.name));
+		out << std::format("      \"ok\": {},\n", res.ok ? "true" : "false");
+		out << std::format("      \"objects\": {}, \"depth\": {}, \"animations\": {}, \"scenes\": {},\n", set.objects, set.depth, set.animations, set.scenes);
+		out << std::format("      \"width\": {}, \"height\": {}, \"fps\": {}, \"duration_ms\": {},\n", set.width, set.height, set.fps, set.durationMs);
+		out << std::format("      \"input_bytes\": {}, \"parse_mb_per_s\": {:.2f},\n", res.inputBytes, res.parseThroughput);
+		out << std::format("      \"frames\": {},\n", res.frames);
+		out << std::format("      \"base_memory_bytes\": {}, \"peak_memory_bytes\": {}, \"memory_growth_bytes\": {},\n", res.baseMemory, res.peakMemory,
+			(res.peakMemory > res.baseMemory) ? res.peakMemory - res.baseMemory : 0);
+		out << std::format("      \"scene_entities\": {}, \"instance_bytes\": {}, \"instance_bytes_per_entity\": {}, \"shared_bytes\": {},\n",
+			res.sceneEntities, res.instanceMemory, res.instanceMemory / std::max<size_t>(res.sceneEntities, 1), res.sharedMemory);
+		out << "      \"phases\": {";
+
+		for (size_t p = 0; p < res.phases.size(); p++) {
+			auto& ph = res.phases[p];
+			const double perFrame = res.frames > 0 ? ph.seconds * 1000.0 / static_cast<double>(res.frames) : 0.0;
+
+			out << std::format("{}\n        \"{}\": {{ \"seconds\": {:.6f}, \"ms_per_frame\": {:.4f} }}", (p > 0) ? "," : "", Escape_JSON(ph.name), ph.seconds, perFrame);
+		}
+
+		out << "\n      }\n";
+		out << std::format("    }}{}\n", (i + 1 < mResults.size()) ? "," : "");
+	}
+
+	out << "  ]\n";
+	out << "}\n";
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include <string>
+
+#include "bench_controller.h"
+
+/*
+ * Benchmark report - collects results of all cases and writes them as JSON
+ */
+class CBench_Report {
+	private:
+		// results of all cases in order of execution
+		std::vector<TBench_Result> mResults;
+		// number of worker threads used
+		size_t mJobs = 1;
+
+	public:
+		explicit CBench_Report(size_t jobs);
+
+		// adds a result of a single case
+		void Add(const TBench_Result& result);
+		// writes the report as JSON
+		void Write(std::ostream& out) const;
+		// did all cases succeed?
+		bool Is_Ok() const;
+};
@@ -0,0 +1,137 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+
+#include "bench_controller.h"
+#include "bench_report.h"
+
+#include <spdlog/spdlog.h>
+
+/*
+ * Benchmark case definition
+ */
+struct TBench_Case {
+	std::string name;					// case name (also used for generated file names)
+	TGenerator_Settings settings;		// generated scene settings
+};
+
+// builds the benchmark suite; every case scales a single dimension of the baseline
+static std::vector<TBench_Case> Build_Suite(bool quick) {
+
+	TGenerator_Settings base;
+	if (quick) {
+		base.durationMs = 2000;
+	}
+
+	std::vector<TBench_Case> suite;
+	suite.push_back({ "baseline", base });
+
+	auto add = [&suite, &base](const std::string& name, auto&& modify) {
+		TGenerator_Settings set = base;
+		modify(set);
+		suite.push_back({ name, set });
+	};
+
+	for (size_t objects : (quick ? std::vector<size_t>{ 1000 } : std::vector<size_t>{ 10, 1000, 5000, 10000 })) {
+		add("objects_" + std::to_string(objects), [objects](auto& s) { s.objects = objects; });
+	}
+	for (size_t depth : (quick ? std::vector<size_t>{ 4 } : std::vector<size_t>{ 1, 4, 8 })) {
+		add("depth_" + std::to_string(depth), [depth](auto& s) { s.depth = depth; });
+	}
+	for (size_t animations : (quick ? std::vector<size_t>{ 100 } : std::vector<size_t>{ 0, 100, 1000 })) {
+		add("animations_" + std::to_string(animations), [animations](auto& s) { s.animations = animations; });
+	}
+	for (auto [w, h] : (quick ? std::vector<std::pair<size_t, size_t>>{ { 1280, 720 } } : std::vector<std::pair<size_t, size_t>>{ { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } })) {
+		add("resolution_" + std::to_string(w) + "x" + std::to_string(h), [w, h](auto& s) { s.width = w; s.height = h; });
+	}
+	add("scenes_8", [](auto& s) { s.scenes = 8; });
+
+	return suite;
+}
+
+int main(int argc, char** argv) {
+
+	std::filesystem::path outputFile;
+	std::filesystem::path workDir = "bench_work";
+	std::string filter;
+	size_t jobs = std::max(std::thread::hardware_concurrency(), 1u);
+	bool stitch = false;
+	bool quick = false;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+
+		if (arg == "--stitch") {
+			stitch = true;
+		}
+		else if (arg == "--quick") {
+			quick = true;
+		}
+		else if ((arg == "--output" || arg == "--work-dir" || arg == "--case" || arg == "--jobs") && i + 1 < argc) {
+			const std::string value = argv[++i];
+
+			if (arg == "--output") {
+				outputFile = value;
+			}
+			else if (arg == "--work-dir") {
+				workDir = value;
+			}
+			else if (arg == "--case") {
+				filter = value;
+			}
+			else {
+				try {
+					jobs = std::max<size_t>(std::stoul(value), 1);
+				}
+				catch (std::exception&) {
+					spdlog::error("Invalid value '{}' for the --jobs option", value);
+					return 1;
+				}
+			}
+		}
+		else {
+			spdlog::error("Usage: {} [--quick] [--stitch] [--jobs N] [--case name] [--work-dir dir] [--output results.json]", argv[0]);
+			return 1;
+		}
+	}
+
+	// per-frame logging would dominate the measurements
+	spdlog::set_level(spdlog::level::warn);
+
+	CBench_Report report(jobs);
+
+	for (auto& bc : Build_Suite(quick)) {
+		if (!filter.empty() && bc.name.find(filter) == std::string::npos) {
+			continue;
+		}
+
+		std::cerr << "Running " << bc.name << "..." << std::endl;
+
+		TBench_Result result;
+		CBench_Controller ctrl;
+		if (!ctrl.Run_Case(bc.name, bc.settings, workDir, jobs, stitch, result)) {
+			spdlog::error("Benchmark case {} failed", bc.name);
+		}
+
+		report.Add(result);
+	}
+
+	if (outputFile.empty()) {
+		report.Write(std::cout);
+	}
+	else {
+		std::ofstream out(outputFile);
+		report.Write(out);
+
+		if (!out) {
+			spdlog::error("Cannot write results to {}", outputFile.string());
+			return 1;
+		}
+	}
+
+	return report.Is_Ok() ? 0 : 2;
+}
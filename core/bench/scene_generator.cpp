@@ -0,0 +1,96 @@
+#include "scene_generator.h"
+
+#include <format>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// palette the generated objects cycle through
+	const char* Palette[] = { "#E63946", "#F1FAEE", "#A8DADC", "#457B9D", "#1D3557", "#FFB703", "#8ECAE6", "#2A9D8F" };
+	constexpr size_t Palette_Size = sizeof(Palette) / sizeof(Palette[0]);
+}
+
+CScene_Generator::CScene_Generator(const TGenerator_Settings& settings) : mSettings(settings) {
+	//
+}
+
+std::string CScene_Generator::Generate() const {
+
+	std::string out;
+
+	out += std::format("Config(version = 1, width = {}, height = {}, fps = {}, defaultbackground = RGB('#000000'))\n\n", mSettings.width, mSettings.height, mSettings.fps);
+
+	if (mSettings.depth > 0) {
+		Generate_Prototypes(out);
+	}
+
+	out += "Constants {\n    accent = RGB('#FF0000')\n}\n\n";
+
+	for (size_t i = 0; i < std::max(mSettings.scenes, static_cast<size_t>(1)); i++) {
+		Generate_Scene(out, i);
+	}
+
+	return out;
+}
+
+void CScene_Generator::Generate_Prototypes(std::string& out) const {
+
+	out += "Proto {\n";
+
+	// every level contains the previous one, so the deepest one has all the levels inside
+	for (size_t level = 1; level <= mSettings.depth; level++) {
+		out += std::format("    Nest{} = Composite(tint) {{\n", level);
+
+		if (level > 1) {
+			out += std::format("        Nest{}(x = 4, y = 4, scale = 0.8, tint = RGB('{}'))\n", level - 1, Palette[level % Palette_Size]);
+		}
+
+		out += "        Circle(x = 20, y = 20, r = 12, fill = tint, stroke = RGB('#FFFFFF'), strokewidth = 2)\n";
+		out += std::format("        Rectangle(x = 0, y = 36, width = 40, height = 6, fill = RGB('{}'))\n", Palette[(level + 3) % Palette_Size]);
+		out += "    }\n";
+	}
+
+	out += "}\n\n";
+}
+
+void CScene_Generator::Generate_Scene(std::string& out, size_t sceneIndex) const {
+
+	out += std::format("Scene(duration = {}ms) {{\n", mSettings.durationMs);
+
+	// objects are spread on a grid covering the whole canvas
+	const size_t columns = std::max(static_cast<size_t>(1), static_cast<size_t>(std::sqrt(static_cast<double>(mSettings.objects))));
+	const size_t rows = std::max(static_cast<size_t>(1), (mSettings.objects + columns - 1) / columns);
+	const double cellW = static_cast<double>(mSettings.width) / static_cast<double>(columns);
+	const double cellH = static_cast<double>(mSettings.height) / static_cast<double>(rows);
+
+	for (size_t i = 0; i < mSettings.objects; i++) {
+		const double x = static_cast<double>(i % columns) * cellW;
+		const double y = static_cast<double>(i / columns) * cellH;
+		const char* color = Palette[(i + sceneIndex) % Palette_Size];
+
+		if (mSettings.depth > 0) {
+			out += std::format("    o{} = Nest{}(x = {:.1f}, y = {:.1f}, tint = RGB('{}'))\n", i, mSettings.depth, x, y, color);
+		}
+		else if (i % 2 == 0) {
+			out += std::format("    o{} = Rectangle(x = {:.1f}, y = {:.1f}, width = {:.1f}, height = {:.1f}, fill = RGB('{}'))\n", i, x, y, cellW * 0.8, cellH * 0.8, color);
+		}
+		else {
+			out += std::format("    o{} = Circle(x = {:.1f}, y = {:.1f}, r = {:.1f}, fill = accent, stroke = RGB('{}'), strokewidth = 2)\n", i, x + cellW / 2, y + cellH / 2, std::min(cellW, cellH) * 0.4, color);
+		}
+	}
+
+	if (mSettings.animations > 0 && mSettings.objects > 0) {
+		// let the scene stand still for a while first, so the timeline has something to schedule; durations are converted
+		// to frames in whole seconds, so they are kept at whole seconds here as well
+		out += "    Wait(duration = 1s)\n";
+
+		const size_t animDuration = std::max(mSettings.durationMs / 2000 * 1000, static_cast<size_t>(1000));
+
+		for (size_t i = 0; i < mSettings.animations; i++) {
+			const size_t target = (i * 7919) % mSettings.objects;
+			out += std::format("    o{}.Animate(x = {:.1f}, rotate = {}, duration = {}ms)\n", target, static_cast<double>((i * 37) % mSettings.width), (i * 15) % 360, animDuration);
+		}
+	}
+
+	out += "}\n\n";
+}
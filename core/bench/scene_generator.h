@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Settings of a generated scene
+ */
+struct TGenerator_Settings {
+	size_t objects = 100;			// number of objects in the scene
+	size_t depth = 0;				// nesting depth of composite objects (0 = plain rectangles and circles)
+	size_t animations = 10;			// number of animations
+	size_t width = 640;				// canvas width
+	size_t height = 480;			// canvas height
+	size_t fps = 30;				// video framerate
+	size_t durationMs = 4000;		// scene duration in milliseconds (whole seconds, the frame count is computed from seconds)
+	size_t scenes = 1;				// number of scenes
+};
+
+/*
+ * Synthetic scene generator - produces .vdef source with a scalable number of objects, nesting depth and animations
+ */
+class CScene_Generator {
+	private:
+		// generator settings
+		TGenerator_Settings mSettings;
+
+	protected:
+		// appends prototypes of nested composite objects
+		void Generate_Prototypes(std::string& out) const;
+		// appends a single scene
+		void Generate_Scene(std::string& out, size_t sceneIndex) const;
+
+	public:
+		explicit CScene_Generator(const TGenerator_Settings& settings);
+
+		// generates the .vdef source
+		std::string Generate() const;
+};
@@ -13,19 +13,17 @@ bool CConfig::Build(CBlock* configBlock) {
 		return false;
 	}
 
-	auto mp = params->Get_Parameters();
-
-	auto getParam = [&mp]<typename T>(const std::string& key, T&& default_val) -> T {
-		auto itr = mp.find(key);
-		if (itr == mp.end())
+	auto getParam = [params]<typename T>(TSymbol key, T&& default_val) -> T {
+		auto* val = params->Find_Parameter(key);
+		if (!val)
 			return default_val;
-		return std::get<T>(itr->second.value);
+		return std::get<T>(val->value);
 	};
 
-	mWidth = static_cast<size_t>(getParam("width", (double)mWidth));
-	mHeight = static_cast<size_t>(getParam("height", (double)mHeight));
-	mFPS = static_cast<size_t>(getParam("fps", (double)mFPS));
-	mDefault_Background = getParam("defaultbackground", (rgb_t)mDefault_Background);
+	mWidth = static_cast<size_t>(getParam(Symbols::Width, (double)mWidth));
+	mHeight = static_cast<size_t>(getParam(Symbols::Height, (double)mHeight));
+	mFPS = static_cast<size_t>(getParam(Symbols::FPS, (double)mFPS));
+	mDefault_Background = getParam(Symbols::Default_Background, (rgb_t)mDefault_Background);
 
 	mInitialized = true;
 
@@ -57,6 +55,10 @@ size_t CConfig::Get_Height() const {
 	return mHeight;
 }
 
+void CConfig::Reset() {
+	*this = CConfig();
+}
+
 size_t CConfig::Get_FPS() const {
 	return mFPS;
 }
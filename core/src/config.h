@@ -4,6 +4,8 @@
 
 /*
  * Global config for generated videos
+ *
+ * Built once while parsing the input and read-only afterwards, so it may be read from multiple threads
  */
 class CConfig
 {
@@ -32,6 +34,8 @@ class CConfig
 
 		// builds the config from given config block
 		bool Build(CBlock* configBlock);
+		// restores the default config, so another input may be built (must not be called while rendering)
+		void Reset();
 
 		// is the config initialized properly?
 		bool Is_Initialized() const;
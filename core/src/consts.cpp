@@ -14,24 +14,24 @@ bool CConsts::Build(CBlock* block) {
 	auto subc = cmd->Get_Subcommands();
 
 	for (auto& sc : subc) {
-		if (sc->Get_Identifier().empty()) {
+		const TSymbol key = sc->Get_Identifier();
+		if (key == Invalid_Symbol) {
 			spdlog::error("Constants must have a name!");
 			return false;
 		}
-		
-		std::string namecopy(sc->Get_Identifier());
-		std::transform(namecopy.begin(), namecopy.end(), namecopy.begin(), [](char c) { return std::tolower(c); });
-		
-		if (mConsts.find(namecopy) != mConsts.end()) {
-			spdlog::error("Multiple definition of constant '{}'!", sc->Get_Identifier());
+
+		auto itr = std::lower_bound(mConsts.begin(), mConsts.end(), key, [](auto& entry, TSymbol k) { return entry.first < k; });
+
+		if (itr != mConsts.end() && itr->first == key) {
+			spdlog::error("Multiple definition of constant '{}'!", sSymbols.Get_Name(key));
 			return false;
 		}
 		else if (!sc->Get_Value().has_value()) {
-			spdlog::error("Constant '{}' does not have a valid value", sc->Get_Identifier());
+			spdlog::error("Constant '{}' does not have a valid value", sSymbols.Get_Name(key));
 			return false;
 		}
 
-		mConsts[namecopy] = sc->Get_Value().value();
+		mConsts.insert(itr, { key, sc->Get_Value().value() });
 	}
 
 	return true;
@@ -41,6 +41,12 @@ bool CConsts::Is_Initialized() const {
 	return mInitialized;
 }
 
-const TValue_Spec& CConsts::Get_Constant(const std::string& key) const {
-	return mConsts.at(key);
+void CConsts::Reset() {
+	mConsts.clear();
+	mInitialized = false;
+}
+
+const TValue_Spec* CConsts::Find_Constant(TSymbol key) const {
+	auto itr = std::lower_bound(mConsts.begin(), mConsts.end(), key, [](auto& entry, TSymbol k) { return entry.first < k; });
+	return (itr != mConsts.end() && itr->first == key) ? &itr->second : nullptr;
 }
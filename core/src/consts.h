@@ -1,18 +1,22 @@
 #pragma once
 
 #include "parser_entities.h"
+#include "symbols.h"
 
-#include <map>
+#include <vector>
+#include <utility>
 
 /*
  * Global constants store
+ *
+ * Filled from the constants block before rendering starts; lookups never modify it, so concurrently rendered scenes may share it
  */
 class CConsts {
 	private:
 		// is the const store initialized?
 		bool mInitialized = false;
-		// stored constants
-		std::map<std::string, TValue_Spec> mConsts;
+		// stored constants sorted by name symbol
+		std::vector<std::pair<TSymbol, TValue_Spec>> mConsts;
 
 		// private constructor to avoid multiple instantiation
 		CConsts();
@@ -26,11 +30,13 @@ class CConsts {
 
 		// builds the constants store from given consts block
 		bool Build(CBlock* block);
+		// removes all constants, so another input may be built (must not be called while rendering)
+		void Reset();
 
 		// is the const store initialized?
 		bool Is_Initialized() const;
-		// retrieves constant from the store, if there is any
-		const TValue_Spec& Get_Constant(const std::string& key) const;
+		// retrieves constant from the store; returns nullptr, if there is no such constant
+		const TValue_Spec* Find_Constant(TSymbol key) const;
 };
 
 #define sConsts CConsts::Instance()
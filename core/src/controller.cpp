@@ -6,65 +6,223 @@
 #include <memory>
 #include <format>
 #include <filesystem>
-#include "parser_entities.h"
-#include "vdlang_lex.h"
-#include "vdlang_parser.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "parse_tree.h"
+#include "input_buffer.h"
 
 #include "config.h"
 #include "consts.h"
 #include "prototypes.h"
 #include "scene.h"
+#include "render/pipeline.h"
+#include "profiler.h"
 
 #include "controller.h"
 
 #include <blend2d.h>
 #include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <SimpleIni.h>
 #include <libexecstream/exec-stream.h>
 
-// blocks defined by the parser file
-extern std::vector<CBlock*> _Blocks;
-
-/*
- * Helper RAII class for wrapping the bison parser
- */
-class CAnalyzer_State {
-	private:
-		// bison buffer state
-		YY_BUFFER_STATE m_state;
-
-	public:
-		// constructs the analyzer helper using input string to be parsed
-		CAnalyzer_State(const std::string& input) {
-			if (!(m_state = yy_scan_bytes(input.c_str(), static_cast<int>(input.length())))) {
-				throw std::invalid_argument{ "Cannot parse the input string" };
+CController::CController() {
+	//
+}
+
+CController::~CController() {
+	//
+}
+
+int CController::Initialize(const std::vector<std::string>& argv) {
+
+	// load cli parameters
+
+	mJobs = std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::vector<std::string> positional;
+
+	// the frame format may be set in the config file as well, the command line takes precedence
+	std::optional<std::string> frameFormat;
+	std::optional<int> compression;
+	std::optional<size_t> encoders;
+	std::optional<size_t> writeBudget;
+	bool directIO = false;
+	bool archive = false;
+	bool stitchAfter = false;
+
+	for (size_t i = 1; i < argv.size(); i++) {
+		if (argv[i] == "--stream") {
+			mStream_Output = true;
+		}
+		else if (argv[i] == "--incremental") {
+			mIncremental = true;
+		}
+		else if (argv[i] == "--profile") {
+			mProfile = true;
+		}
+		else if (argv[i] == "--trace") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --trace option");
+				return 1;
 			}
+
+			mProfile = true;
+			mTrace_File = argv[++i];
+		}
+		else if (argv[i] == "--concat") {
+			mConcat_Segments = true;
 		}
+		else if (argv[i] == "--frames") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --frames option");
+				return 1;
+			}
+
+			const std::string& range = argv[++i];
+			const auto dash = range.find('-');
+
+			try {
+				if (dash == std::string::npos) {
+					throw std::invalid_argument{ "Missing range separator" };
+				}
+
+				mFrame_Range = std::make_pair(std::stoul(range.substr(0, dash)), std::stoul(range.substr(dash + 1)));
+			}
+			catch (std::exception&) {
+				spdlog::error("Invalid value '{}' for the --frames option, expected a range like 0-899", range);
+				return 1;
+			}
 
-		virtual ~CAnalyzer_State() {
-			yy_delete_buffer(m_state);
+			if (mFrame_Range->first > mFrame_Range->second) {
+				spdlog::error("The --frames range must not be empty");
+				return 1;
+			}
 		}
+		else if (argv[i] == "--jobs") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --jobs option");
+				return 1;
+			}
 
-		// parses the input, throws an exception on error
-		void Parse() {
-			auto result = yyparse();
+			try {
+				mJobs = std::stoul(argv[++i]);
+			}
+			catch (std::exception&) {
+				spdlog::error("Invalid value '{}' for the --jobs option", argv[i]);
+				return 1;
+			}
 
-			if (result != 0) {
-				throw std::runtime_error{ "The input cannot be parsed due to syntax errors" };
+			if (mJobs == 0) {
+				spdlog::error("The --jobs option must be at least 1");
+				return 1;
 			}
 		}
-};
+		else if (argv[i] == "--encoders") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --encoders option");
+				return 1;
+			}
 
-CController::CController() {
-	//
-}
+			try {
+				encoders = std::stoul(argv[++i]);
+			}
+			catch (std::exception&) {
+				spdlog::error("Invalid value '{}' for the --encoders option", argv[i]);
+				return 1;
+			}
 
-int CController::Initialize(const std::vector<std::string>& argv) {
+			if (*encoders == 0) {
+				spdlog::error("The --encoders option must be at least 1");
+				return 1;
+			}
+		}
+		else if (argv[i] == "--direct-io") {
+			directIO = true;
+		}
+		else if (argv[i] == "--archive") {
+			archive = true;
+		}
+		else if (argv[i] == "--stitch-after") {
+			stitchAfter = true;
+		}
+		else if (argv[i] == "--replay") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --replay option");
+				return 1;
+			}
 
-	// load cli parameters
+			mReplay_Archive = argv[++i];
+		}
+		else if (argv[i] == "--write-budget") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --write-budget option");
+				return 1;
+			}
 
-	mSource_File = argv[1];
-	mOutput_Directory = argv[2];
+			try {
+				writeBudget = std::stoul(argv[++i]);
+			}
+			catch (std::exception&) {
+				spdlog::error("Invalid value '{}' for the --write-budget option", argv[i]);
+				return 1;
+			}
+		}
+		else if (argv[i] == "--format") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --format option");
+				return 1;
+			}
+
+			frameFormat = argv[++i];
+		}
+		else if (argv[i] == "--compression") {
+			if (i + 1 >= argv.size()) {
+				spdlog::error("Missing value for the --compression option");
+				return 1;
+			}
+
+			try {
+				compression = std::stoi(argv[++i]);
+			}
+			catch (std::exception&) {
+				spdlog::error("Invalid value '{}' for the --compression option", argv[i]);
+				return 1;
+			}
+		}
+		else {
+			positional.push_back(argv[i]);
+		}
+	}
+
+	// the replayed frames go to the standard output, so the log has to go elsewhere
+	if (!mReplay_Archive.empty()) {
+		spdlog::set_default_logger(spdlog::stderr_color_mt("stderr"));
+		return 0;
+	}
+
+	if (mConcat_Segments ? positional.empty() : (positional.size() < 2)) {
+		spdlog::error("Usage: {} [--jobs N] [--encoders N] [--format png|qoi|ppm|bmp|raw] [--compression 0-9] [--write-budget MB] [--direct-io] [--archive] [--stitch-after] [--stream] [--incremental] [--frames A-B] [--profile] [--trace file.json] <input.vdef | -> <output directory>", argv.empty() ? "vidgenx" : argv[0]);
+		spdlog::error("       {} --concat <output directory>", argv.empty() ? "vidgenx" : argv[0]);
+		spdlog::error("       {} --replay <archive.vfa> | ffmpeg <printed input options> -i - <output video>", argv.empty() ? "vidgenx" : argv[0]);
+		return 1;
+	}
+
+	if (mConcat_Segments) {
+		mOutput_Directory = positional[0];
+	}
+	else {
+		mSource_File = positional[0];
+		mOutput_Directory = positional[1];
+	}
 
 	// load config file
 
@@ -78,24 +236,77 @@ int CController::Initialize(const std::vector<std::string>& argv) {
 	if (mFFMPEG_Binary.empty())
 		mFFMPEG_Binary = "ffmpeg";
 
+	mFFMPEG_Stall_Seconds = static_cast<size_t>(std::max(appConfig.GetLongValue("general", "ffmpeg_stall_timeout", 60), 1L));
+
+	const std::string formatName = frameFormat.value_or(appConfig.GetValue("output", "frame_format", "png"));
+	auto format = CFrame_Encoder::Parse_Format(formatName);
+	if (!format.has_value()) {
+		spdlog::error("Unknown frame format '{}', expected one of png, qoi, ppm, bmp or raw", formatName);
+		return 1;
+	}
+
+	mEncoder_Settings.format = format.value();
+	mEncoder_Settings.compression = compression.value_or(static_cast<int>(appConfig.GetLongValue("output", "png_compression", -1)));
+
+	if (mEncoder_Settings.compression < -1 || mEncoder_Settings.compression > 9) {
+		spdlog::error("The PNG compression level must be between 0 and 9");
+		return 1;
+	}
+	if (mEncoder_Settings.compression >= 0 && !CFrame_Encoder::Is_Compression_Supported(mEncoder_Settings.compression)) {
+		spdlog::warn("PNG compression level {} requires zlib, which is not available in this build; using the default PNG encoder", mEncoder_Settings.compression);
+		mEncoder_Settings.compression = -1;
+	}
+
+	mEncoders = encoders.value_or(static_cast<size_t>(appConfig.GetLongValue("output", "encoders", static_cast<long>(mJobs))));
+	mEncoders = std::max(mEncoders, static_cast<size_t>(1));
+
+	const std::string writerName = appConfig.GetValue("output", "writer", "auto");
+	auto writer = CFrame_Sink::Parse_Backend(writerName);
+	if (!writer.has_value()) {
+		spdlog::error("Unknown frame writer '{}', expected one of auto, thread or uring", writerName);
+		return 1;
+	}
+
+	mSink_Settings.backend = writer.value();
+	mSink_Settings.memoryBudget = writeBudget.value_or(static_cast<size_t>(appConfig.GetLongValue("output", "write_budget_mb", 256))) * 1024 * 1024;
+	mSink_Settings.directIO = directIO || appConfig.GetBoolValue("output", "direct_io", false);
+
+	mArchive_Frames = archive || appConfig.GetBoolValue("output", "archive", false);
+	mOverlap_Stitch = !stitchAfter && appConfig.GetBoolValue("output", "overlap_stitch", true);
+
+	const std::string videoBackendName = appConfig.GetValue("output", "stream_encoder", "auto");
+	auto videoBackend = CVideo_Encoder::Parse_Backend(videoBackendName);
+	if (!videoBackend.has_value()) {
+		spdlog::error("Unknown stream encoder '{}', expected one of auto, libav or ffmpeg", videoBackendName);
+		return 1;
+	}
+	mVideo_Backend = videoBackend.value();
+
+	mVideo_Container = appConfig.GetValue("output", "stream_container", "mp4");
+	if (mVideo_Container != "mp4" && mVideo_Container != "mkv") {
+		spdlog::error("Unknown stream container '{}', expected mp4 or mkv", mVideo_Container);
+		return 1;
+	}
+
+	if (mProfile) {
+		sProfiler.Enable();
+		sProfiler.Set_Thread_Name("Main");
+	}
+
 	return 0;
 }
 
 bool CController::Parse_Input_Files() {
 	spdlog::info("Parsing the input file");
 
-	try {
-		std::ifstream ifs(mSource_File);
-
-		std::string str((std::istreambuf_iterator<char>(ifs)),
-			std::istreambuf_iterator<char>());
-
-		CAnalyzer_State state(str);
-
-		state.Parse();
+	auto input = CInput_Buffer::Open(mSource_File);
+	if (!input) {
+		return false;
 	}
-	catch (std::exception& ex) {
-		spdlog::error("Cannot parse the input file, error: {}", ex.what());
+
+	mParse_Tree = std::make_unique<CParse_Tree>(std::move(input));
+	if (!mParse_Tree->Parse()) {
+		spdlog::error("The input cannot be parsed due to syntax errors");
 		return false;
 	}
 
@@ -104,17 +315,19 @@ bool CController::Parse_Input_Files() {
 
 bool CController::Parse_Blocks() {
 
+	auto& blocks = mParse_Tree->Get_Blocks();
+
 	// sort by block index (primary sort)
-	std::sort(_Blocks.begin(), _Blocks.end(), [](const CBlock* a, const CBlock* b) {
+	std::sort(blocks.begin(), blocks.end(), [](const CBlock* a, const CBlock* b) {
 		return static_cast<int>(a->Get_Block_Index()) < static_cast<int>(b->Get_Block_Index());
 	});
 
 	// sort by type to preserve correct loading order: config, constants, prototypes, scenes
-	std::stable_sort(_Blocks.begin(), _Blocks.end(), [](const CBlock* a, const CBlock* b) {
+	std::stable_sort(blocks.begin(), blocks.end(), [](const CBlock* a, const CBlock* b) {
 		return static_cast<int>(a->Get_Type()) < static_cast<int>(b->Get_Type());
 	});
 
-	for (auto& bl : _Blocks) {
+	for (auto& bl : blocks) {
 
 		switch (bl->Get_Type()) {
 			case NBlock_Type::Config:
@@ -162,94 +375,595 @@ bool CController::Parse_Blocks() {
 	return true;
 }
 
+bool CController::Render_Scene(CRender_Pipeline& pipeline, size_t channel, const TScene_Range& range) {
+
+	auto& scene = *mScenes[range.scene];
+
+	CProfile_Scope scope("scene", sProfiler.Is_Enabled() ? sProfiler.Intern_Name(std::format("Scene {}", range.scene)) : "");
+
+	// the last recorded frame is held back until we know, whether the following frames are identical to it
+	std::unique_ptr<CFrame_Snapshot> held;
+	size_t deduplicated = 0;
+
+	if (range.first == 0 ? !scene.Begin() : !scene.Seek(range.first)) {
+		return false;
+	}
+
+	do {
+		spdlog::debug("Rendering scene {}, frame {}", range.scene, scene.Get_Current_Frame());
+
+		auto snapshot = std::make_unique<CFrame_Snapshot>(range.frameOffset + scene.Get_Current_Frame());
+
+		scene.Render_Frame(*snapshot);
+
+		if (held && !scene.Is_Frame_Changed()) {
+			held->Add_Repeat();
+			deduplicated++;
+			continue;
+		}
+
+		if (held && !pipeline.Submit(channel, std::move(held))) {
+			return false;
+		}
+
+		held = std::move(snapshot);
+	} while (scene.Get_Current_Frame() < range.last && scene.Next_Frame());
+
+	if (held && !pipeline.Submit(channel, std::move(held))) {
+		return false;
+	}
+
+	spdlog::info("Scene {}: {} frames, {} deduplicated", range.scene, range.last - range.first + 1, deduplicated);
+
+	return true;
+}
+
 bool CController::Render_Scenes() {
-	mTotal_Frames = 0;
 
-	for (size_t scIdx = 0; scIdx < mScenes.size(); scIdx++)
-	{
-		mScenes[scIdx]->Begin();
-		do {
-			spdlog::info("Rendering scene {}, frame {}", scIdx, mScenes[scIdx]->Get_Current_Frame());
+	// scene lengths are known up front, so every scene knows, where its frames belong
+	std::vector<size_t> frameOffsets;
+	size_t videoFrames = 0;
 
-			BLImage img(static_cast<int>(sConfig.Get_Width()), static_cast<int>(sConfig.Get_Height()), BL_FORMAT_PRGB32);
-			BLContext ctx(img);
+	for (auto& scene : mScenes) {
+		frameOffsets.push_back(videoFrames);
+		videoFrames += scene->Get_Frame_Count();
+	}
+
+	// the default range would end before its first frame
+	if (videoFrames == 0) {
+		spdlog::error("The input defines no frames to render");
+		return false;
+	}
+
+	const auto range = mFrame_Range.value_or(std::make_pair(static_cast<size_t>(0), videoFrames - 1));
+	if (range.second >= videoFrames) {
+		spdlog::error("Cannot render frames {}-{}, the video has only {} frames", range.first, range.second, videoFrames);
+		return false;
+	}
+
+	mFirst_Frame = range.first;
+	mTotal_Frames = range.second - range.first + 1;
+
+	// scenes (or their parts) overlapping the requested range
+	std::vector<TScene_Range> sceneRanges;
+	for (size_t i = 0; i < mScenes.size(); i++) {
+		const size_t sceneEnd = frameOffsets[i] + mScenes[i]->Get_Frame_Count() - 1;
+		if (sceneEnd < range.first || frameOffsets[i] > range.second) {
+			continue;
+		}
+
+		sceneRanges.push_back({ i, frameOffsets[i], std::max(range.first, frameOffsets[i]) - frameOffsets[i], std::min(range.second, sceneEnd) - frameOffsets[i] });
+	}
+
+	if (mStream_Output) {
+		if (!Start_Encoder_Stream()) {
+			return false;
+		}
+	}
+	else if (mOverlap_Stitch) {
+		// the encoded frames are piped to ffmpeg as they are written, so the video is ready shortly after the last frame
+		Start_Stitch_Stream();
+	}
+
+	// scenes are independent, so every producer thread records a different scene, each through its own pipeline channel
+	const size_t producers = std::max(std::min(sceneRanges.size(), mJobs), static_cast<size_t>(1));
+
+	TPipeline_Settings settings;
+	settings.jobs = mJobs;
+	settings.encoders = mEncoders;
+	settings.encoder = mEncoder_Settings;
+	settings.sink = mSink_Settings;
+	if (mArchive_Frames) {
+		settings.sink.archive = Get_Video_Path("vfa");
+		settings.sink.archiveInfo.format = mEncoder_Settings.format;
+		settings.sink.archiveInfo.width = static_cast<uint32_t>(sConfig.Get_Width());
+		settings.sink.archiveInfo.height = static_cast<uint32_t>(sConfig.Get_Height());
+		settings.sink.archiveInfo.fps = static_cast<uint32_t>(sConfig.Get_FPS());
+		settings.sink.archiveInfo.firstFrame = mFirst_Frame;
+	}
+	settings.channels = producers;
+	settings.width = static_cast<int>(sConfig.Get_Width());
+	settings.height = static_cast<int>(sConfig.Get_Height());
+	settings.outputDirectory = mOutput_Directory;
+	settings.rawStream = (mEncoder_Stream && mStream_Output) ? &mEncoder_Stream->in() : nullptr;
+	settings.imageStream = (mEncoder_Stream && !mStream_Output) ? &mEncoder_Stream->in() : nullptr;
+	settings.videoEncoder = mVideo_Encoder.get();
+	settings.incremental = mIncremental;
+	settings.firstFrame = mFirst_Frame;
+
+	CRender_Pipeline pipeline(settings);
+
+	std::atomic<size_t> nextRange{ 0 };
+	std::atomic<bool> failed{ false };
+
+	auto producer = [&](size_t channel) {
+		if (channel > 0) {
+			sProfiler.Set_Thread_Name(std::format("Scene producer {}", channel));
+		}
+
+		for (size_t rIdx = nextRange++; rIdx < sceneRanges.size() && !failed; rIdx = nextRange++) {
+			if (!Render_Scene(pipeline, channel, sceneRanges[rIdx])) {
+				failed = true;
+			}
+		}
+	};
+	std::vector<std::thread> producerThreads;
+	for (size_t i = 1; i < producers; i++) {
+		producerThreads.emplace_back(producer, i);
+	}
+
+	// the calling thread is a producer as well
+	producer(0);
+
+	for (auto& thr : producerThreads) {
+		thr.join();
+	}
+
+	bool result = !failed;
+
+	if (!pipeline.Finish()) {
+		spdlog::error("Some of the frames could not be rendered");
+		result = false;
+	}
+
+	pipeline.Report();
 
-			ctx.setCompOp(BL_COMP_OP_SRC_COPY);
-			ctx.fillAll();
+	// an incomplete video is of no use, ffmpeg would just wait for the rest of the frames; when just the pipe broke, the
+	// frame files are complete, so the video is stitched from them afterwards
+	if ((!result || pipeline.Is_Pipe_Broken()) && mEncoder_Stream) {
+		try {
+			mEncoder_Stream->kill();
+		}
+		catch (std::exception&) {
+			// it may have exited already
+		}
+		mEncoder_Stream.reset();
+	}
 
-			mScenes[scIdx]->Render_Frame(ctx);
+	return result;
+}
 
-			ctx.end();
+bool CController::Start_Encoder_Stream() {
 
-			std::string filename = std::format("frame_{:06}.png", (mTotal_Frames + mScenes[scIdx]->Get_Current_Frame()));
+	// encoding in-process saves piping every frame to another process
+	if (mVideo_Backend != NVideo_Backend::FFMPEG) {
+		if (CVideo_Encoder::Is_Available()) {
+			TVideo_Settings settings;
+			settings.path = Get_Video_Path(mVideo_Container);
+			settings.width = static_cast<int>(sConfig.Get_Width());
+			settings.height = static_cast<int>(sConfig.Get_Height());
+			settings.fps = static_cast<int>(sConfig.Get_FPS());
 
-			img.writeToFile((mOutput_Directory / filename).string().c_str());
-		} while (mScenes[scIdx]->Next_Frame());
+			mVideo_Encoder = CVideo_Encoder::Create(settings);
+			if (mVideo_Encoder) {
+				return true;
+			}
 
-		mTotal_Frames += mScenes[scIdx]->Get_Current_Frame();
+			spdlog::warn("Cannot start the in-process video encoder, falling back to the ffmpeg binary");
+		}
+		else if (mVideo_Backend == NVideo_Backend::Libav) {
+			spdlog::warn("This build does not support in-process video encoding, falling back to the ffmpeg binary");
+		}
+	}
+
+	spdlog::info("Starting ffmpeg to encode the streamed frames...");
+
+	try {
+		mEncoder_Stream = std::make_unique<exec_stream_t>();
+
+		// frames are written raw, so ffmpeg has to be told, what to expect
+		const std::string inputSpec = Get_Pipe_Input_Spec(NFrame_Format::Raw, sConfig.Get_Width(), sConfig.Get_Height(), sConfig.Get_FPS());
+
+		mEncoder_Stream->set_binary_mode(exec_stream_t::s_in);
+		// do not buffer more than a single frame - a slow encoder has to slow down the rendering
+		mEncoder_Stream->set_buffer_limit(exec_stream_t::s_in, sConfig.Get_Width() * sConfig.Get_Height() * 4);
+		// ffmpeg not accepting a frame for too long is considered stuck
+		mEncoder_Stream->set_wait_timeout(exec_stream_t::s_in, static_cast<exec_stream_t::timeout_t>(mFFMPEG_Stall_Seconds * 1000));
+
+		Start_FFMPEG(*mEncoder_Stream, inputSpec + " -y -pix_fmt yuv420p \"" + Get_Video_Path(mVideo_Container).string() + "\"");
+	}
+	catch (std::exception& ex) {
+		spdlog::error("Cannot start ffmpeg: {}", ex.what());
+		mEncoder_Stream.reset();
+		return false;
 	}
 
 	return true;
 }
 
-bool CController::Stitch_Video() {
-	spdlog::info("Stitching frames to a video...");
+void CController::Start_Stitch_Stream() {
+	spdlog::info("Starting ffmpeg to stitch the frames as they are rendered...");
 
 	try {
+		mEncoder_Stream = std::make_unique<exec_stream_t>();
 
-		const auto ffmpegStdoutFile = mOutput_Directory / "ffmpeg_stdout.log";
-		const auto ffmpegStderrFile = mOutput_Directory / "ffmpeg_stderr.log";
+		mEncoder_Stream->set_binary_mode(exec_stream_t::s_in);
+		// encoded frames are smaller than raw ones, so a few of them fit in; a slow encoder then slows down the rendering
+		mEncoder_Stream->set_buffer_limit(exec_stream_t::s_in, sConfig.Get_Width() * sConfig.Get_Height() * 4);
+		mEncoder_Stream->set_wait_timeout(exec_stream_t::s_in, static_cast<exec_stream_t::timeout_t>(mFFMPEG_Stall_Seconds * 1000));
 
-		exec_stream_t stream;
-		// give it a maximum of half a second per frame (e.g., for 120 frames, give it a minute to finish)
-		stream.set_wait_timeout(exec_stream_t::s_all, static_cast<exec_stream_t::timeout_t>(mTotal_Frames * 500));
+		const auto format = mEncoder_Settings.format;
+		Start_FFMPEG(*mEncoder_Stream, Get_Pipe_Input_Spec(format, sConfig.Get_Width(), sConfig.Get_Height(), sConfig.Get_FPS()) + " -y " + Get_Stitch_Output_Spec(format) + " \"" + Get_Video_Path("avi").string() + "\"");
+	}
+	catch (std::exception& ex) {
+		// the frame files are written anyway, so the video may still be stitched from them afterwards
+		spdlog::warn("Cannot start ffmpeg ({}), the video will be stitched after rendering", ex.what());
+		mEncoder_Stream.reset();
+	}
+}
 
-		stream.start(mFFMPEG_Binary.string(), "-framerate " + std::to_string(sConfig.Get_FPS()) + " -pattern_type sequence -i \"" + mOutput_Directory.string() + "\\frame_%06d.png\" -y -c:v copy -pix_fmt yuv420p " + mOutput_Directory.string() + "\\out.avi");
-		stream.close_in(); // we don't need stdin (for now, maybe later for streamlining the video generation directly from frames)
+void CController::Start_FFMPEG(exec_stream_t& stream, const std::string& arguments) {
+	// the progress report replaces the statistics line on the standard error, and tells, whether ffmpeg is still alive
+	stream.start(mFFMPEG_Binary.string(), "-nostats -progress pipe:1 " + arguments);
+}
 
-		std::ostringstream oss_out, oss_err;
+bool CController::Finish_FFMPEG(exec_stream_t& stream) {
 
-		char buffer[4096];
-		while (stream.out().read(buffer, sizeof(buffer)))
-			oss_out << std::string_view{ buffer, sizeof(buffer) };
-		oss_out << std::string_view{ buffer, static_cast<size_t>(stream.out().gcount()) };
+	const auto ffmpegStdoutFile = mOutput_Directory / "ffmpeg_stdout.log";
+	const auto ffmpegStderrFile = mOutput_Directory / "ffmpeg_stderr.log";
+
+	std::ostringstream oss_out, oss_err;
+
+	// ffmpeg reports its progress at least twice a second while it's working, no matter how long the video is; when it stays
+	// silent for the whole stall timeout, it is stuck
+	stream.set_wait_timeout(exec_stream_t::s_out | exec_stream_t::s_err | exec_stream_t::s_child, static_cast<exec_stream_t::timeout_t>(mFFMPEG_Stall_Seconds * 1000));
+
+	bool completed = false;
+	// time ffmpeg wrote anything last; tells a stall from other failures
+	auto lastOutput = std::chrono::steady_clock::now();
+
+	try {
+		auto lastReport = lastOutput;
+		std::string line;
+
+		while (std::getline(stream.out(), line)) {
+			lastOutput = std::chrono::steady_clock::now();
 
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			oss_out << line << '\n';
+
+			if (line.starts_with("frame=")) {
+				const auto now = std::chrono::steady_clock::now();
+				if (now - lastReport >= std::chrono::seconds(10)) {
+					spdlog::info("ffmpeg progress: {} frames", line.substr(6));
+					lastReport = now;
+				}
+			}
+			else if (line == "progress=end") {
+				completed = true;
+			}
+		}
+
+		if (stream.out().bad()) {
+			throw std::runtime_error{ "The progress report cannot be read" };
+		}
+
+		char buffer[4096];
 		while (stream.err().read(buffer, sizeof(buffer)))
 			oss_err << std::string_view{ buffer, sizeof(buffer) };
 		oss_err << std::string_view{ buffer, static_cast<size_t>(stream.err().gcount()) };
+	}
+	catch (std::exception& ex) {
+		if (std::chrono::steady_clock::now() - lastOutput >= std::chrono::seconds(mFFMPEG_Stall_Seconds)) {
+			spdlog::error("ffmpeg made no progress for {} s, stopping it", mFFMPEG_Stall_Seconds);
+		}
+		else {
+			spdlog::error("Cannot read the output of ffmpeg: {}", ex.what());
+		}
+		completed = false;
+
+		try {
+			stream.kill();
+		}
+		catch (std::exception&) {
+			// it may have exited meanwhile
+		}
+	}
 
-		// write out stdout/stderr to log file
+	// write out stdout/stderr to log file
 
-		std::ofstream out_file(ffmpegStdoutFile.string());
-		out_file << oss_out.str();
+	std::ofstream out_file(ffmpegStdoutFile.string());
+	out_file << oss_out.str();
 
-		std::ofstream err_file(ffmpegStderrFile.string());
-		err_file << oss_err.str();
+	std::ofstream err_file(ffmpegStderrFile.string());
+	err_file << oss_err.str();
+
+	if (!completed) {
+		spdlog::error("Failed to generate a video; please, see the ffmpeg_stdout.log and ffmpeg_stderr.log files in output directory for details");
+	}
+
+	return completed;
+}
+
+bool CController::Stitch_Video() {
+
+	// the frames were already encoded as they were rendered, just complete the video
+	if (mVideo_Encoder) {
+		const bool ok = mVideo_Encoder->Finish();
+		mVideo_Encoder.reset();
+		return ok;
+	}
+
+	try {
+
+		// the frames were already piped to a running ffmpeg instance, just let it finish
+		if (mEncoder_Stream) {
+			spdlog::info("Waiting for ffmpeg to complete the video...");
+
+			mEncoder_Stream->close_in();
+
+			const bool ok = Finish_FFMPEG(*mEncoder_Stream);
+			mEncoder_Stream.reset();
+
+			return ok;
+		}
+
+		spdlog::info("Stitching frames to a video...");
+
+		exec_stream_t stream;
+
+		// the archived frames are piped to ffmpeg in order, it does not have to look for any files
+		if (mArchive_Frames) {
+			CFrame_Archive_Reader archive;
+			if (!archive.Open(Get_Video_Path("vfa"))) {
+				return false;
+			}
+
+			const auto& info = archive.Get_Info();
+
+			stream.set_binary_mode(exec_stream_t::s_in);
+			stream.set_wait_timeout(exec_stream_t::s_in, static_cast<exec_stream_t::timeout_t>(mFFMPEG_Stall_Seconds * 1000));
+			Start_FFMPEG(stream, Get_Pipe_Input_Spec(info.format, info.width, info.height, info.fps) + " -y " + Get_Stitch_Output_Spec(info.format) + " \"" + Get_Video_Path("avi").string() + "\"");
+
+			const bool streamed = Stream_Archive(archive, stream.in());
+			stream.close_in();
+
+			return Finish_FFMPEG(stream) && streamed;
+		}
+
+		std::string inputSpec = "-framerate " + std::to_string(sConfig.Get_FPS()) + " -pattern_type sequence -start_number " + std::to_string(mFirst_Frame);
+
+		if (mEncoder_Settings.format == NFrame_Format::Raw) {
+			// bare pixels carry no dimensions
+			inputSpec += std::format(" -c:v rawvideo -pixel_format bgra -video_size {}x{}", sConfig.Get_Width(), sConfig.Get_Height());
+		}
+
+		const std::string framePattern = std::format("frame_%06d.{}", CFrame_Encoder::Get_Extension(mEncoder_Settings.format));
+
+		Start_FFMPEG(stream, inputSpec + " -i \"" + (mOutput_Directory / framePattern).string() + "\" -frames:v " + std::to_string(mTotal_Frames) + " -y " + Get_Stitch_Output_Spec(mEncoder_Settings.format) + " \"" + Get_Video_Path("avi").string() + "\"");
+		stream.close_in(); // we don't need stdin, the frames are read from files
+
+		return Finish_FFMPEG(stream);
 	}
 	catch (std::exception& ex) {
 		spdlog::error("An exception occurred when generating a video: {}", ex.what());
 		spdlog::error("Failed to generate a video; please, see the ffmpeg_stdout.log and ffmpeg_stderr.log files in output directory for details");
 	}
 
+	return false;
+}
+
+std::filesystem::path CController::Get_Video_Path(const std::string& extension) const {
+
+	if (mFrame_Range.has_value()) {
+		return mOutput_Directory / std::format("segment_{:06}-{:06}.{}", mFrame_Range->first, mFrame_Range->second, extension);
+	}
+
+	return mOutput_Directory / ("out." + extension);
+}
+
+bool CController::Concat_Segments() {
+	spdlog::info("Concatenating video segments...");
+
+	// segment names contain zero-padded frame numbers, so sorting by name sorts them by frames
+	std::vector<std::filesystem::path> segments;
+
+	std::error_code ec;
+	for (auto& entry : std::filesystem::directory_iterator(mOutput_Directory, ec)) {
+		const auto name = entry.path().filename().string();
+		if (entry.is_regular_file() && name.starts_with("segment_") && (entry.path().extension() == ".mp4" || entry.path().extension() == ".mkv" || entry.path().extension() == ".avi")) {
+			segments.push_back(entry.path());
+		}
+	}
+
+	if (ec || segments.empty()) {
+		spdlog::error("Cannot find any video segments in {}", mOutput_Directory.string());
+		return false;
+	}
+
+	std::sort(segments.begin(), segments.end());
+
+	for (size_t i = 1; i < segments.size(); i++) {
+		if (segments[i].extension() != segments[0].extension()) {
+			spdlog::error("Segments {} and {} have different formats, cannot concatenate them", segments[0].string(), segments[i].string());
+			return false;
+		}
+	}
+
+	const auto listFile = mOutput_Directory / "segments.txt";
+	{
+		std::ofstream list(listFile);
+		for (auto& seg : segments) {
+			list << "file '" << std::filesystem::absolute(seg).string() << "'\n";
+		}
+
+		if (!list) {
+			spdlog::error("Cannot write segment list {}", listFile.string());
+			return false;
+		}
+	}
+
+	try {
+		exec_stream_t stream;
+
+		// all segments were encoded with the same settings, so the streams may be copied as they are
+		Start_FFMPEG(stream, "-f concat -safe 0 -i \"" + listFile.string() + "\" -y -c copy \"" + (mOutput_Directory / ("out" + segments[0].extension().string())).string() + "\"");
+		stream.close_in();
+
+		if (!Finish_FFMPEG(stream)) {
+			return false;
+		}
+	}
+	catch (std::exception& ex) {
+		spdlog::error("An exception occurred when concatenating video segments: {}", ex.what());
+		return false;
+	}
+
+	spdlog::info("Concatenated {} segments", segments.size());
+
 	return true;
 }
 
+bool CController::Stream_Archive(const CFrame_Archive_Reader& archive, std::ostream& stream) {
+
+	for (size_t i = 0; i < archive.Get_Frame_Count(); i++) {
+		const auto frame = archive.Get_Frame(i);
+
+		// the pipe demuxers just split the stream to frames, a missing one would shift the rest of the video
+		if (frame.empty()) {
+			spdlog::error("Frame {} is missing in the archive", archive.Get_Info().firstFrame + i);
+			return false;
+		}
+
+		stream.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+		if (!stream) {
+			spdlog::error("Cannot write frame {} from the archive", archive.Get_Info().firstFrame + i);
+			return false;
+		}
+	}
+
+	stream.flush();
+
+	return static_cast<bool>(stream);
+}
+
+std::string CController::Get_Pipe_Input_Spec(NFrame_Format format, size_t width, size_t height, size_t fps) {
+
+	// bare pixels carry no dimensions
+	if (format == NFrame_Format::Raw) {
+		return std::format("-f rawvideo -pix_fmt bgra -s {}x{} -r {} -i -", width, height, fps);
+	}
+
+	return std::format("-f {}_pipe -framerate {} -i -", CFrame_Encoder::Get_Extension(format), fps);
+}
+
+std::string CController::Get_Stitch_Output_Spec(NFrame_Format format) {
+
+	// PNG frames are just copied into the video (a stream copy keeps their pixel format, so none is requested); other formats
+	// are converted to PNG, so all segments of a video share the codec
+	return (format == NFrame_Format::PNG) ? "-c:v copy" : "-c:v png";
+}
+
+bool CController::Replay_Archive() {
+
+	CFrame_Archive_Reader archive;
+	if (!archive.Open(mReplay_Archive)) {
+		return false;
+	}
+
+	const auto& info = archive.Get_Info();
+	spdlog::info("Replaying {} frames ({}x{}, {} fps) from frame {}; ffmpeg input options: {}", archive.Get_Frame_Count(), info.width, info.height, info.fps, info.firstFrame, Get_Pipe_Input_Spec(info.format, info.width, info.height, info.fps));
+
+#ifdef _WIN32
+	// the frames are binary, the newlines must not be translated
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	std::cout.sync_with_stdio(false);
+
+	return Stream_Archive(archive, std::cout);
+}
+
+std::vector<std::unique_ptr<CScene>>& CController::Get_Scenes() {
+	return mScenes;
+}
+
+const std::filesystem::path& CController::Get_Output_Directory() const {
+	return mOutput_Directory;
+}
+
+const TEncoder_Settings& CController::Get_Encoder_Settings() const {
+	return mEncoder_Settings;
+}
+
+void CController::Reset_Global_State() {
+	sConfig.Reset();
+	sConsts.Reset();
+	sPrototypes.Reset();
+}
+
 int CController::Run() {
 
-	if (!Parse_Input_Files()) {
-		return 1;
+	const int result = Run_Phases();
+
+	if (mProfile) {
+		if (!mTrace_File.empty()) {
+			sProfiler.Write_Trace(mTrace_File);
+		}
+		sProfiler.Print_Summary();
+	}
+
+	return result;
+}
+
+int CController::Run_Phases() {
+
+	if (mConcat_Segments) {
+		return Concat_Segments() ? 0 : 4;
+	}
+
+	if (!mReplay_Archive.empty()) {
+		return Replay_Archive() ? 0 : 4;
 	}
 
-	if (!Parse_Blocks()) {
-		return 2;
+	{
+		CProfile_Scope scope("phase", "Parse_Input_Files");
+		if (!Parse_Input_Files()) {
+			return 1;
+		}
+	}
+
+	{
+		CProfile_Scope scope("phase", "Parse_Blocks");
+		if (!Parse_Blocks()) {
+			return 2;
+		}
 	}
 
-	if (!Render_Scenes()) {
-		return 3;
+	{
+		CProfile_Scope scope("phase", "Render_Scenes");
+		if (!Render_Scenes()) {
+			return 3;
+		}
 	}
 
-	if (!Stitch_Video()) {
-		return 4;
+	{
+		CProfile_Scope scope("phase", "Stitch_Video");
+		if (!Stitch_Video()) {
+			return 4;
+		}
 	}
 
 	spdlog::info("Completed");
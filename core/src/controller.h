@@ -3,8 +3,29 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <optional>
+#include <utility>
+#include <memory>
 
 #include "scene.h"
+#include "render/frame_encoder.h"
+#include "render/frame_sink.h"
+#include "render/frame_archive.h"
+#include "render/video_encoder.h"
+
+class exec_stream_t;
+class CRender_Pipeline;
+class CParse_Tree;
+
+/*
+ * Part of a scene to be rendered
+ */
+struct TScene_Range {
+	size_t scene = 0;			// index of the scene
+	size_t frameOffset = 0;		// global index of the first scene frame
+	size_t first = 0;			// first scene frame to be rendered
+	size_t last = 0;			// last scene frame to be rendered (inclusive)
+};
 
 /*
  * Application main controller - controls the flow of video rendering
@@ -18,6 +39,11 @@ class CController {
 
 		// path to FFMPEG binary (ffmpeg.exe on Windows or ffmpeg on Linux/macOS)
 		std::filesystem::path mFFMPEG_Binary;
+		// number of seconds ffmpeg may stay without any progress before it's considered stuck
+		size_t mFFMPEG_Stall_Seconds = 60;
+
+		// parsed input; scenes refer to its blocks, so it has to be declared (and thus destroyed) before them
+		std::unique_ptr<CParse_Tree> mParse_Tree;
 
 		// vector of scenes to be rendered
 		std::vector<std::unique_ptr<CScene>> mScenes;
@@ -25,18 +51,92 @@ class CController {
 		// total number of frames to be stitched
 		size_t mTotal_Frames = 0;
 
+		// number of render worker threads (and the maximum number of scenes recorded concurrently)
+		size_t mJobs = 1;
+		// number of frame encoder threads
+		size_t mEncoders = 1;
+		// format of the frame image files
+		TEncoder_Settings mEncoder_Settings;
+		// asynchronous writing of the frame image files
+		TSink_Settings mSink_Settings;
+		// store the frames to a single archive instead of separate image files?
+		bool mArchive_Frames = false;
+		// pipe the image files to ffmpeg while they are being rendered, instead of stitching them afterwards?
+		bool mOverlap_Stitch = true;
+		// archive to be replayed to the standard output instead of rendering
+		std::filesystem::path mReplay_Archive;
+
+		// stream raw frames directly to ffmpeg instead of writing image files?
+		bool mStream_Output = false;
+		// redraw only the changed areas of frames?
+		bool mIncremental = false;
+		// preferred encoder of the streamed frames
+		NVideo_Backend mVideo_Backend = NVideo_Backend::Auto;
+		// container of the streamed video (file extension)
+		std::string mVideo_Container = "mp4";
+		// in-process encoder consuming the streamed frames
+		std::unique_ptr<CVideo_Encoder> mVideo_Encoder;
+		// running ffmpeg instance consuming the streamed frames
+		std::unique_ptr<exec_stream_t> mEncoder_Stream;
+		// range of global frames to be rendered (inclusive); if not set, the whole video is rendered
+		std::optional<std::pair<size_t, size_t>> mFrame_Range;
+		// index of the first rendered frame
+		size_t mFirst_Frame = 0;
+		// just concatenate the segments rendered before instead of rendering?
+		bool mConcat_Segments = false;
+		// record the time spent in rendering phases, scenes and objects?
+		bool mProfile = false;
+		// file to write the recorded profile to as Chrome trace
+		std::filesystem::path mTrace_File;
+
 	protected:
+		// retrieves all scenes built from the input
+		std::vector<std::unique_ptr<CScene>>& Get_Scenes();
+		// retrieves the output directory
+		const std::filesystem::path& Get_Output_Directory() const;
+		// retrieves the format of the frame image files
+		const TEncoder_Settings& Get_Encoder_Settings() const;
+		// forgets the global stores built from the parsed blocks, so another input may be processed
+		static void Reset_Global_State();
+
 		// parses input files into a internal representation
 		bool Parse_Input_Files();
 		// parses blocks from internal representation
 		bool Parse_Blocks();
-		// renders scenes (all frames) based on parsed blocks
+		// renders scenes (all frames) based on parsed blocks; independent scenes are rendered concurrently
 		bool Render_Scenes();
-		// stitches video together using rendered images
+		// records given range of scene frames and submits them to the pipeline through given channel
+		bool Render_Scene(CRender_Pipeline& pipeline, size_t channel, const TScene_Range& range);
+		// stitches video together using rendered images (or finalizes the streamed video)
 		bool Stitch_Video();
 
+		// starts the in-process encoder of the streamed frames, or ffmpeg reading raw frames from its standard input
+		bool Start_Encoder_Stream();
+		// starts ffmpeg, that stitches the image files piped to it as they are rendered; stitching is left for later on failure
+		void Start_Stitch_Stream();
+		// starts ffmpeg with given arguments, reporting its progress to the standard output
+		void Start_FFMPEG(exec_stream_t& stream, const std::string& arguments);
+		// waits for given ffmpeg instance to finish as long as it makes progress and stores its output to log files; returns
+		// false if ffmpeg failed or got stuck
+		bool Finish_FFMPEG(exec_stream_t& stream);
+		// retrieves the path of the output video; a frame range is rendered to a separate segment
+		std::filesystem::path Get_Video_Path(const std::string& extension) const;
+		// concatenates video segments found in the output directory without re-encoding
+		bool Concat_Segments();
+		// writes all the frames of given archive to the stream in order, as the ffmpeg image pipe demuxers expect them
+		static bool Stream_Archive(const CFrame_Archive_Reader& archive, std::ostream& stream);
+		// retrieves ffmpeg input options for frames of given format piped to its standard input
+		static std::string Get_Pipe_Input_Spec(NFrame_Format format, size_t width, size_t height, size_t fps);
+		// retrieves ffmpeg output options for a video stitched of frames of given format
+		static std::string Get_Stitch_Output_Spec(NFrame_Format format);
+		// writes the frames of the replayed archive to the standard output
+		bool Replay_Archive();
+		// runs all the video generation phases
+		int Run_Phases();
+
 	public:
 		CController();
+		virtual ~CController();
 
 		// initialize the controller based on user inputs
 		int Initialize(const std::vector<std::string>& argv);
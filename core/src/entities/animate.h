@@ -3,35 +3,42 @@
 #include "shared.h"
 
 /*
- * Animation entity
+ * Animation entity - holds just the animation definition; the scene compiles it into timeline tracks, that do the animating
  */
 class CEntity_Animate : public CScene_Entity {
-	private:
-		// animation duration
-		CParam_Wrapper<int> mDuration = 0;
-
+	public:
 		// animated parameter structure
 		struct TAnimate_Param {
-			std::string paramName;					// name of the parameter
-			std::optional<TValue_Spec> initial;		// initial value of the parameter
+			TSymbol paramName;						// name of the parameter
 			TValue_Spec target;						// target value of the parameter
 		};
 
+	private:
+		// animation duration
+		CParam_Wrapper<int> mDuration = 0;
+
 		// vector of all animater parameters
 		std::vector<TAnimate_Param> mAnimation_Params;
 
-	protected:
-		// start frame of animation
-		std::optional<size_t> mStart_Frame;
-
 	public:
 		CEntity_Animate() : CScene_Entity(NEntity_Type::Animate) {}
+		CEntity_Animate(const CEntity_Animate& other) : CScene_Entity(other), mDuration(other.mDuration), mAnimation_Params(other.mAnimation_Params) {
+			Rebind_Param(other.mDuration, mDuration);
+		}
 
 		std::unique_ptr<CScene_Entity> Clone() const override {
 			auto ptr = std::make_unique<CEntity_Animate>(*this);
 			return ptr;
 		}
 
+		size_t Get_Storage_Size() const override {
+			return sizeof(CEntity_Animate) + Get_Base_Storage_Size() + mAnimation_Params.capacity() * sizeof(TAnimate_Param);
+		}
+
 		void Apply_Parameters(const CParams* params) override;
-		NExecution_Result Execute(CScene& scene) override;
+
+		// retrieves the animation duration in frames
+		size_t Get_Duration_Frames() const;
+		// retrieves all animated parameters
+		const std::vector<TAnimate_Param>& Get_Animation_Params() const;
 };
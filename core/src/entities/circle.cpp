@@ -1,43 +1,45 @@
 #include "circle.h"
 
 #include "../scene.h"
+#include "../render/frame_snapshot.h"
+#include "../render/bounds.h"
 #include <spdlog/spdlog.h>
 
 void CCircle::Apply_Parameters(const CParams* params) {
 	CScene_Object::Apply_Parameters(params);
 
-	auto pars = params->Get_Parameters();
+	const auto& pars = *params;
 
 	try {
-		Assign_Helper<double>("r", pars, mRadius);
-		Assign_Helper<rgb_t>("fill", pars, mFill_Color);
-		Assign_Helper<rgb_t>("stroke", pars, mStroke_Color);
-		Assign_Helper<double>("strokewidth", pars, mStroke_Width);
+		Assign_Helper<double>(Symbols::R, pars, mRadius);
+		Assign_Helper<rgb_t>(Symbols::Fill, pars, mFill_Color);
+		Assign_Helper<rgb_t>(Symbols::Stroke, pars, mStroke_Color);
+		Assign_Helper<double>(Symbols::Stroke_Width, pars, mStroke_Width);
 	}
 	catch (CInvalid_Parameter_Type& ex) {
 		spdlog::error("The parameter {} has a different type, than expected", ex.Get_Param_Name());
 	}
 }
 
-bool CCircle::Render(BLContext& context, const CTransform& transform) const {
+bool CCircle::Render(CFrame_Snapshot& snapshot, const CTransform& parent) const {
 
-	CTransform_Guard _(transform, context);
-	{
-		CTransform tr(Get_X(), Get_Y(), Get_Rotate(), Get_Scale());
-		CTransform_Guard _(tr, context);
-		{
-			context.setCompOp(BL_COMP_OP_SRC_OVER);
+	TDraw_Primitive prim;
+	prim.type = NObject_Type::Circle;
+	prim.transform = Get_Transform(parent).Get_Matrix();
 
-			context.setFillStyle(BLRgba32(mFill_Color.Get_Value(mDefault_Value_Store)));
-			context.setStrokeStyle(BLRgba32(mStroke_Color.Get_Value(mDefault_Value_Store)));
-			context.setStrokeWidth(mStroke_Width.Get_Value(mDefault_Value_Store));
+	prim.fill = mFill_Color.Get_Value(mDefault_Value_Store);
+	prim.stroke = mStroke_Color.Get_Value(mDefault_Value_Store);
+	prim.strokeWidth = mStroke_Width.Get_Value(mDefault_Value_Store);
+	prim.width = mRadius.Get_Value(mDefault_Value_Store);
 
-			BLCircle circle(0, 0, mRadius.Get_Value(mDefault_Value_Store));
-
-			context.strokeCircle(circle);
-			context.fillCircle(circle);
-		}
-	}
+	snapshot.Add_Primitive(prim);
 
 	return true;
 }
+
+BLBox CCircle::Get_Bounding_Box(const CTransform& parent) const {
+
+	const BLMatrix2D tr = Get_Transform(parent).Get_Matrix();
+
+	return Get_Circle_Bounds(tr, mRadius.Get_Value(mDefault_Value_Store), mStroke_Width.Get_Value(mDefault_Value_Store));
+}
@@ -5,7 +5,7 @@
 /*
  * Circle entity
  */
-class CCircle : public CBasic_Clonable_Scene_Object<CCircle> {
+class CCircle final : public CBasic_Clonable_Scene_Object<CCircle> {
 	private:
 		// circle radius
 		CParam_Wrapper<double> mRadius = 0;
@@ -18,7 +18,14 @@ class CCircle : public CBasic_Clonable_Scene_Object<CCircle> {
 
 	public:
 		CCircle() : CBasic_Clonable_Scene_Object(NObject_Type::Circle) {}
+		CCircle(const CCircle& other) : CBasic_Clonable_Scene_Object(other), mRadius(other.mRadius), mFill_Color(other.mFill_Color), mStroke_Color(other.mStroke_Color), mStroke_Width(other.mStroke_Width) {
+			Rebind_Param(other.mRadius, mRadius);
+			Rebind_Param(other.mFill_Color, mFill_Color);
+			Rebind_Param(other.mStroke_Color, mStroke_Color);
+			Rebind_Param(other.mStroke_Width, mStroke_Width);
+		}
 
 		void Apply_Parameters(const CParams* params) override;
-		bool Render(BLContext& context, const CTransform& transform) const override;
+		bool Render(CFrame_Snapshot& snapshot, const CTransform& parent) const override;
+		BLBox Get_Bounding_Box(const CTransform& parent) const override;
 };
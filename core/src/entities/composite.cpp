@@ -1,7 +1,10 @@
 #include "composite.h"
 
+#include "../objects.h"
 #include "../factory.h"
 #include "../scene.h"
+#include "../render/bounds.h"
+#include "../render/affine_kernel.h"
 #include <spdlog/spdlog.h>
 
 void CComposite::Apply_Parameters(const CParams* params) {
@@ -9,17 +12,16 @@ void CComposite::Apply_Parameters(const CParams* params) {
 
 	CParams p;
 	params->Merge_To(&p);
-	p.Remove_Parameter("x");
-	p.Remove_Parameter("y");
+	p.Remove_Parameter(Symbols::X);
+	p.Remove_Parameter(Symbols::Y);
 
-	auto& rp = p.Get_Parameters();
 	for (auto& rs : mResolvable_Attributes) {
-		if (rp.find(rs) != rp.end())
-			mDefault_Value_Store.Add(rs, rp.at(rs));
+		if (auto* val = p.Find_Parameter(rs))
+			mDefault_Value_Store.Add(rs, *val);
 	}
 
-	for (auto& obj : mObjects)
-		obj->Apply_Parameters(&p);
+	// the shared contents must not be modified, the parameters are passed to them when the draw list is built
+	p.Merge_To(&mChild_Params);
 }
 
 void CComposite::Apply_Body(CCommand* command) {
@@ -28,14 +30,17 @@ void CComposite::Apply_Body(CCommand* command) {
 
 		for (auto sc : sct->Get_Subcommands()) {
 
-			std::string namecopy(sc->Get_Entity_Name());
-			std::transform(namecopy.begin(), namecopy.end(), namecopy.begin(), [](char c) { return std::tolower(c); });
-
-			auto obj = sFactory.Create(namecopy);
+			auto obj = sFactory.Create(sc->Get_Entity_Name());
 
 			if (!obj)
 				continue;
 
+			// the composite only draws its contents, anything else would never be executed
+			if (obj->Get_Type() != NEntity_Type::Object) {
+				spdlog::warn("Composite may contain only drawable objects, '{}' is ignored", sSymbols.Get_Name(sc->Get_Entity_Name()));
+				continue;
+			}
+
 			if (!sc->Get_Subcommands().empty()) {
 				obj->Apply_Body(sc);
 			}
@@ -48,31 +53,143 @@ void CComposite::Apply_Body(CCommand* command) {
 				obj->Apply_Attribute_Block(sc->Get_Attributes());
 			}
 
-			if (!sc->Get_Object_Reference().empty()) {
+			if (sc->Get_Object_Reference() != Invalid_Symbol) {
 				obj->Set_Object_Reference(sc->Get_Object_Reference());
 			}
 
-			mObjects.push_back(std::move(obj));
+			Mutable_Template().objects.emplace_back(static_cast<CScene_Object*>(obj.release()));
 		}
 	}
 
 }
 
-bool CComposite::Render(BLContext& context, const CTransform& transform) const {
+CComposite::TComposite_Template& CComposite::Mutable_Template() {
 
-	CTransform_Guard _(transform, context);
-	{
-		CTransform tr(Get_X(), Get_Y(), Get_Rotate(), Get_Scale());
+	// templates are modified only while building prototypes, which happens on a single thread
+	if (mTemplate.use_count() > 1) {
+		auto copy = std::make_shared<TComposite_Template>();
+		copy->objects.reserve(mTemplate->objects.size());
+		for (auto& obj : mTemplate->objects) {
+			copy->objects.emplace_back(static_cast<CScene_Object*>(obj->Clone().release()));
+		}
+		mTemplate = std::move(copy);
+	}
+
+	return *mTemplate;
+}
+
+std::shared_ptr<const CComposite::TDraw_List> CComposite::Build_Draw_List() const {
+
+	// the primitives are recorded relative to the composite, its own transformation is applied when rendering
+	CFrame_Snapshot local(0);
+
+	for (auto& tobj : mTemplate->objects) {
+		// the object is needed just for recording, so there is always just one copy of a single object at a time
+		auto obj = tobj->Clone();
+
+		obj->Apply_Parameters(&mChild_Params);
+		// attributes of the composite are resolved just once, nested composites pass them further down
+		obj->Get_Value_Store().Merge_With(mDefault_Value_Store);
+		obj->Prepare();
 
-		for (auto& obj : mObjects) {
+		Visit_Object(static_cast<const CScene_Object&>(*obj), [&](auto& object) { return object.Render(local, CTransform::Identity()); });
+	}
+
+	return std::make_shared<const TDraw_List>(local.Take_Primitives());
+}
+
+void CComposite::Prepare() {
 
-			obj->Get_Value_Store().Merge_With(mDefault_Value_Store);
+	auto key = std::make_pair(mChild_Params, mDefault_Value_Store);
 
-			auto* object = dynamic_cast<CScene_Object*>(obj.get());
-			if (object)
-				object->Render(context, tr);
+	{
+		std::unique_lock lck(mTemplate->mutex);
+
+		auto itr = mTemplate->drawLists.find(key);
+		if (itr != mTemplate->drawLists.end()) {
+			mDraw_List = itr->second;
+			return;
 		}
 	}
 
+	auto drawList = Build_Draw_List();
+
+	std::unique_lock lck(mTemplate->mutex);
+
+	// another instance may have built the same list in the meantime
+	mDraw_List = mTemplate->drawLists.emplace(std::move(key), std::move(drawList)).first->second;
+}
+
+bool CComposite::Render(CFrame_Snapshot& snapshot, const CTransform& parent) const {
+
+	const CTransform world = Get_Transform(parent);
+
+	if (!mDraw_List) {
+		return true;
+	}
+
+	for (auto& prim : *mDraw_List) {
+		TDraw_Primitive p = prim;
+		Multiply_Affine(prim.transform, world.Get_Matrix(), p.transform);
+		snapshot.Add_Primitive(p);
+	}
+
 	return true;
 }
+
+BLBox CComposite::Get_Bounding_Box(const CTransform& parent) const {
+
+	const CTransform world = Get_Transform(parent);
+
+	BLBox box = Empty_Box();
+	if (!mDraw_List) {
+		return box;
+	}
+
+	for (auto& prim : *mDraw_List) {
+		TDraw_Primitive p = prim;
+		Multiply_Affine(prim.transform, world.Get_Matrix(), p.transform);
+		box = Union_Box(box, CFrame_Snapshot::Get_Bounds(p));
+	}
+
+	return box;
+}
+
+size_t CComposite::Get_Storage_Size() const {
+	return sizeof(CComposite) + Get_Base_Storage_Size() + mChild_Params.Get_Storage_Size();
+}
+
+void CComposite::Account_Storage(TStorage_Usage& usage) const {
+
+	CScene_Object::Account_Storage(usage);
+
+	// the draw list is shared with all instances of equal parameters
+	auto account_draw_list = [&usage](const std::shared_ptr<const TDraw_List>& list) {
+		if (list && usage.accountedShared.insert(list.get()).second) {
+			usage.sharedBytes += sizeof(TDraw_List) + list->capacity() * sizeof(TDraw_Primitive);
+		}
+	};
+
+	account_draw_list(mDraw_List);
+
+	if (!usage.accountedShared.insert(mTemplate.get()).second) {
+		return;
+	}
+
+	// the contents are shared by all instances, so even their own storage counts as shared
+	TStorage_Usage contents;
+	contents.accountedShared = std::move(usage.accountedShared);
+	for (auto& obj : mTemplate->objects) {
+		obj->Account_Storage(contents);
+	}
+	usage.accountedShared = std::move(contents.accountedShared);
+	usage.sharedBytes += sizeof(TComposite_Template) + mTemplate->objects.capacity() * sizeof(decltype(mTemplate->objects)::value_type)
+		+ contents.instanceBytes + contents.sharedBytes;
+
+	std::unique_lock<std::mutex> lck(mTemplate->mutex);
+
+	for (auto& [key, list] : mTemplate->drawLists) {
+		usage.sharedBytes += sizeof(decltype(mTemplate->drawLists)::value_type) + key.first.Get_Storage_Size() + key.second.Get_Storage_Size();
+		account_draw_list(list);
+	}
+}
@@ -1,25 +1,57 @@
 #pragma once
 
 #include "shared.h"
+#include "../render/frame_snapshot.h"
+
+#include <mutex>
+#include <map>
 
 /*
  * Composite entity - an entity containing one or more other entities
+ *
+ * Only the composite itself may be animated, its contents are static; the contents are built once with the prototype and
+ * shared by all its instances, every instance stores just its own parameters and attributes. When the instance is prepared,
+ * the contents are recorded into a draw list relative to the composite; instances with the same parameters share the draw list
  */
-class CComposite : public CBasic_Clonable_Scene_Object<CComposite> {
+class CComposite final : public CBasic_Clonable_Scene_Object<CComposite> {
 	private:
-		// list of object instances, that are encapsulated within this composite entity
-		std::list<std::unique_ptr<CScene_Entity>> mObjects;
+		// draw list (primitives of all contained objects in the composite coordinates)
+		using TDraw_List = std::vector<TDraw_Primitive>;
+
+		// contents shared by the prototype and all its instances
+		struct TComposite_Template {
+			// drawable objects from the composite body; not modified once the prototype is built
+			std::vector<std::unique_ptr<CScene_Object>> objects;
+
+			// guards the draw lists, as scenes may be instantiated on multiple threads
+			std::mutex mutex;
+			// draw lists already built, by the parameters passed to the contents and the composite attributes
+			std::map<std::pair<CParams, CValue_Store>, std::shared_ptr<const TDraw_List>> drawLists;
+		};
+
+		// shared contents
+		std::shared_ptr<TComposite_Template> mTemplate = std::make_shared<TComposite_Template>();
+		// parameters passed to the contained objects (all the composite parameters except the position)
+		CParams mChild_Params;
+		// draw list of this instance; empty until prepared
+		std::shared_ptr<const TDraw_List> mDraw_List;
+
+	protected:
+		// retrieves the contents for modification; if they are shared with another composite, they are copied first
+		TComposite_Template& Mutable_Template();
+		// builds the draw list for current parameters and attributes
+		std::shared_ptr<const TDraw_List> Build_Draw_List() const;
 
 	public:
 		CComposite() : CBasic_Clonable_Scene_Object(NObject_Type::Composite) {}
 
-		// it is important to perform deep copy on copy-semantic invocation
-		CComposite(const CComposite& other) : CBasic_Clonable_Scene_Object(other) {
-			for (auto& obj : other.mObjects)
-				mObjects.push_back(obj->Clone());
-		}
-
 		void Apply_Body(CCommand* command) override;
 		void Apply_Parameters(const CParams* params) override;
-		bool Render(BLContext& context, const CTransform& transform) const override;
+		// resolves the draw list for the composite parameters and attributes; a composite draws nothing until prepared
+		void Prepare() override;
+		bool Render(CFrame_Snapshot& snapshot, const CTransform& parent) const override;
+		BLBox Get_Bounding_Box(const CTransform& parent) const override;
+
+		size_t Get_Storage_Size() const override;
+		void Account_Storage(TStorage_Usage& usage) const override;
 };
@@ -1,43 +1,47 @@
 #include "rectangle.h"
 
 #include "../scene.h"
+#include "../render/frame_snapshot.h"
+#include "../render/bounds.h"
 #include <spdlog/spdlog.h>
 
 void CRectangle::Apply_Parameters(const CParams* params) {
 	CScene_Object::Apply_Parameters(params);
 
-	auto pars = params->Get_Parameters();
+	const auto& pars = *params;
 
 	try {
-		Assign_Helper<double>("width", pars, mWidth);
-		Assign_Helper<double>("height", pars, mHeight);
-		Assign_Helper<rgb_t>("fill", pars, mFill_Color);
-		Assign_Helper<rgb_t>("stroke", pars, mStroke_Color);
-		Assign_Helper<int>("strokewidth", pars, mStroke_Width);
+		Assign_Helper<double>(Symbols::Width, pars, mWidth);
+		Assign_Helper<double>(Symbols::Height, pars, mHeight);
+		Assign_Helper<rgb_t>(Symbols::Fill, pars, mFill_Color);
+		Assign_Helper<rgb_t>(Symbols::Stroke, pars, mStroke_Color);
+		Assign_Helper<int>(Symbols::Stroke_Width, pars, mStroke_Width);
 	}
 	catch (CInvalid_Parameter_Type& ex) {
 		spdlog::error("The parameter {} has a different type, than expected", ex.Get_Param_Name());
 	}
 }
 
-bool CRectangle::Render(BLContext& context, const CTransform& transform) const {
+bool CRectangle::Render(CFrame_Snapshot& snapshot, const CTransform& parent) const {
 
-	CTransform_Guard _(transform, context);
-	{
-		CTransform tr(Get_X(), Get_Y(), Get_Rotate(), Get_Scale());
-		CTransform_Guard _(tr, context);
+	TDraw_Primitive prim;
+	prim.type = NObject_Type::Rectangle;
+	prim.transform = Get_Transform(parent).Get_Matrix();
 
-		context.setCompOp(BL_COMP_OP_SRC_OVER);
+	prim.fill = mFill_Color.Get_Value(mDefault_Value_Store);
+	prim.stroke = mStroke_Color.Get_Value(mDefault_Value_Store);
+	prim.strokeWidth = mStroke_Width.Get_Value(mDefault_Value_Store);
+	prim.width = mWidth.Get_Value(mDefault_Value_Store);
+	prim.height = mHeight.Get_Value(mDefault_Value_Store);
 
-		context.setFillStyle(BLRgba32(mFill_Color.Get_Value(mDefault_Value_Store)));
-		context.setStrokeStyle(BLRgba32(mStroke_Color.Get_Value(mDefault_Value_Store)));
-		context.setStrokeWidth(mStroke_Width.Get_Value(mDefault_Value_Store));
+	snapshot.Add_Primitive(prim);
 
-		BLRect rect(0, 0, mWidth.Get_Value(mDefault_Value_Store), mHeight.Get_Value(mDefault_Value_Store));
+	return true;
+}
 
-		context.strokeRect(rect);
-		context.fillRect(rect);
-	}
+BLBox CRectangle::Get_Bounding_Box(const CTransform& parent) const {
 
-	return true;
+	const BLMatrix2D tr = Get_Transform(parent).Get_Matrix();
+
+	return Get_Rectangle_Bounds(tr, mWidth.Get_Value(mDefault_Value_Store), mHeight.Get_Value(mDefault_Value_Store), mStroke_Width.Get_Value(mDefault_Value_Store));
 }
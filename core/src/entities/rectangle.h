@@ -5,7 +5,7 @@
 /*
  * Rectangle entity
  */
-class CRectangle : public CBasic_Clonable_Scene_Object<CRectangle> {
+class CRectangle final : public CBasic_Clonable_Scene_Object<CRectangle> {
 	private:
 		// rectangle width
 		CParam_Wrapper<double> mWidth = 0;
@@ -20,7 +20,15 @@ class CRectangle : public CBasic_Clonable_Scene_Object<CRectangle> {
 
 	public:
 		CRectangle() : CBasic_Clonable_Scene_Object(NObject_Type::Rectangle) {}
+		CRectangle(const CRectangle& other) : CBasic_Clonable_Scene_Object(other), mWidth(other.mWidth), mHeight(other.mHeight), mFill_Color(other.mFill_Color), mStroke_Color(other.mStroke_Color), mStroke_Width(other.mStroke_Width) {
+			Rebind_Param(other.mWidth, mWidth);
+			Rebind_Param(other.mHeight, mHeight);
+			Rebind_Param(other.mFill_Color, mFill_Color);
+			Rebind_Param(other.mStroke_Color, mStroke_Color);
+			Rebind_Param(other.mStroke_Width, mStroke_Width);
+		}
 
 		void Apply_Parameters(const CParams* params) override;
-		bool Render(BLContext& context, const CTransform& transform) const override;
+		bool Render(CFrame_Snapshot& snapshot, const CTransform& parent) const override;
+		BLBox Get_Bounding_Box(const CTransform& parent) const override;
 };
@@ -5,14 +5,31 @@
 
 #include <spdlog/spdlog.h>
 
+NObject_Type CScene_Object::Get_Object_Type() const {
+	return mObject_Type;
+}
+
 CScene_Object::CScene_Object(NObject_Type type) : CScene_Entity(NEntity_Type::Object), mObject_Type(type) {
 	//
 }
 
+CScene_Object::CScene_Object(const CScene_Object& other)
+	: CScene_Entity(other), mX(other.mX), mY(other.mY), mRotate(other.mRotate), mScale(other.mScale), mObject_Type(other.mObject_Type) {
+
+	Rebind_Param(other.mX, mX);
+	Rebind_Param(other.mY, mY);
+	Rebind_Param(other.mRotate, mRotate);
+	Rebind_Param(other.mScale, mScale);
+}
+
 CScene_Object::~CScene_Object() {
 	//
 }
 
+CTransform CScene_Object::Get_Transform(const CTransform& parent) const {
+	return CTransform(Get_X(), Get_Y(), Get_Rotate(), Get_Scale()) * parent;
+}
+
 double CScene_Object::Get_X() const {
 	return mX.Get_Value(mDefault_Value_Store);
 }
@@ -30,13 +47,13 @@ double CScene_Object::Get_Scale() const {
 }
 
 void CScene_Object::Apply_Parameters(const CParams* params) {
-	auto pars = params->Get_Parameters();
+	const auto& pars = *params;
 
 	try {
-		Assign_Helper<double>("x", pars, mX);
-		Assign_Helper<double>("y", pars, mY);
-		Assign_Helper<double>("rotate", pars, mRotate);
-		Assign_Helper<double>("scale", pars, mScale);
+		Assign_Helper<double>(Symbols::X, pars, mX);
+		Assign_Helper<double>(Symbols::Y, pars, mY);
+		Assign_Helper<double>(Symbols::Rotate, pars, mRotate);
+		Assign_Helper<double>(Symbols::Scale, pars, mScale);
 	}
 	catch (CInvalid_Parameter_Type& ex) {
 		spdlog::error("The parameter {} has a different type, than expected", ex.Get_Param_Name());
@@ -5,11 +5,19 @@
 #include <blend2d.h>
 #include <stdexcept>
 #include <set>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <spdlog/spdlog.h>
 
 #include "../consts.h"
+#include "../symbols.h"
 #include "../parser_entities.h"
+#include "../render/affine_kernel.h"
 
 class CScene;
+class CFrame_Snapshot;
 
 /*
  * Type of scene entity
@@ -43,6 +51,9 @@ enum class NObject_Type {
 // convenience macro
 constexpr size_t Object_Type_Count = static_cast<size_t>(NObject_Type::count);
 
+// names of drawable object types (indexed by NObject_Type)
+constexpr const char* Object_Type_Names[Object_Type_Count] = { "none", "rectangle", "circle", "composite" };
+
 /*
  * Result of entity execution
  */
@@ -74,121 +85,143 @@ class CInvalid_Parameter_Type : public std::exception {
 };
 
 /*
- * Container class representing canvas transformation
+ * Affine canvas transformation - transformations are concatenated directly, so the world transformation of an object
+ * is computed once by a single multiplication with the transformation of its parent
+ *
+ * Points are transformed as row vectors (the same convention as BLMatrix2D), so "a * b" applies a first, then b
  */
 class CTransform {
 	private:
-		// offset
-		double mX = 0, mY = 0;
-		// rotation
-		double mRotate = 0;
-		// scale
-		double mScale = 1.0;
+		// transformation matrix
+		BLMatrix2D mMatrix;
 
 	public:
-		CTransform() {};
-		CTransform(double x, double y, double rotate = 0, double scale = 1.0) : mX(x), mY(y), mRotate(rotate), mScale(scale) {}
-
-		CTransform(const CTransform& other) : mX(other.mX), mY(other.mY), mRotate(other.mRotate), mScale(other.mScale) {}
-		CTransform(CTransform&& other) noexcept : mX(other.mX), mY(other.mY), mRotate(other.mRotate), mScale(other.mScale) {}
-
-		CTransform& operator=(const CTransform& other) {
-			mX = other.mX; mY = other.mY; mRotate = other.mRotate; mScale = other.mScale;
-		}
-		CTransform& operator=(CTransform&& other) noexcept {
-			mX = other.mX; mY = other.mY; mRotate = other.mRotate; mScale = other.mScale;
-		}
-
-		double Get_X() const {
-			return mX;
-		}
-
-		double Get_Y() const {
-			return mY;
-		}
-
-		double Get_Rotate() const {
-			return mRotate;
-		}
-
-		double Get_Scale() const {
-			return mScale;
+		CTransform() : mMatrix(1.0, 0.0, 0.0, 1.0, 0.0, 0.0) {}
+		explicit CTransform(const BLMatrix2D& matrix) : mMatrix(matrix) {}
+		// scales, then rotates (in radians), then translates
+		CTransform(double x, double y, double rotate = 0, double scale = 1.0) {
+			const double c = std::cos(rotate) * scale;
+			const double s = std::sin(rotate) * scale;
+			mMatrix = BLMatrix2D(c, s, -s, c, x, y);
 		}
 
-		// applies transformation to given context
-		void Apply(BLContext& ctx) const {
-			ctx.translate(mX, mY);
-			ctx.rotate(mRotate);
-			ctx.scale(mScale);
+		// concatenates transformations; the result applies this transformation first, then the other one
+		CTransform operator*(const CTransform& other) const {
+			CTransform result;
+			Multiply_Affine(mMatrix, other.mMatrix, result.mMatrix);
+			return result;
 		}
 
-		// reverses the transformation on a given context
-		void Unapply(BLContext& ctx) const {
-			ctx.scale(1.0 / mScale);
-			ctx.rotate(-mRotate);
-			ctx.translate(-mX, -mY);
+		// retrieves the transformation matrix
+		const BLMatrix2D& Get_Matrix() const {
+			return mMatrix;
 		}
 
 		// generates an identity transformation
 		static CTransform Identity() {
-			return CTransform(0, 0, 0, 1.0);
+			return CTransform();
 		}
 };
 
 /*
- * Transform RAII guard to apply transformation upon construction and unapply during destruction
+ * Value store to serve as parameter/attribute resolver - a flat vector sorted by key symbol, so a lookup is
+ * a binary search over a few integers; lookups never throw, a missing or mistyped value is reported as an empty result
  */
-class CTransform_Guard {
+class CValue_Store {
 	private:
-		const CTransform& mTransform;
-		BLContext& mContext;
+		// stored value
+		struct TStore_Entry {
+			TSymbol key = Invalid_Symbol;				// name of the value (attribute name)
+			TValue_Spec value;							// the value itself
+			TSymbol reference = Invalid_Symbol;			// name of the referenced constant, if the value is an identifier
 
-	public:
-		CTransform_Guard(const CTransform& transform, BLContext& context) : mTransform(transform), mContext(context) {
-			mTransform.Apply(mContext);
-		}
+			auto operator<=>(const TStore_Entry&) const = default;
+		};
 
-		~CTransform_Guard() {
-			mTransform.Unapply(mContext);
+		// stored values (attribute values) sorted by key
+		std::vector<TStore_Entry> mValues;
+
+	protected:
+		// retrieves the entry with given key, or nullptr if there is none
+		const TStore_Entry* Find_Entry(TSymbol key) const {
+			auto itr = std::lower_bound(mValues.begin(), mValues.end(), key, [](const TStore_Entry& entry, TSymbol k) { return entry.key < k; });
+			return (itr != mValues.end() && itr->key == key) ? &(*itr) : nullptr;
 		}
-};
 
-/*
- * Value store to serve as parameter/attribute resolver
- */
-class CValue_Store {
-	private:
-		// stored values (attribute values)
-		std::map<std::string, TValue_Spec> mValues;
+		// retrieves a constant of given type
+		template<typename T>
+		static std::optional<T> Find_Constant(TSymbol key) {
+			if (auto* cval = sConsts.Find_Constant(key)) {
+				if (auto* val = std::get_if<T>(&cval->value)) {
+					return *val;
+				}
+			}
+			return std::nullopt;
+		}
 
 	public:
+		// retrieves the number of bytes allocated for the values
+		size_t Get_Storage_Size() const {
+			return mValues.capacity() * sizeof(TStore_Entry);
+		}
+
 		// adds a new value to store
-		void Add(const std::string& key, const TValue_Spec& value) {
-			mValues[key] = value;
+		void Add(TSymbol key, const TValue_Spec& value) {
+			TStore_Entry entry{ key, value, Invalid_Symbol };
+			if (value.type == NValue_Type::Identifier) {
+				entry.reference = value.symbol;
+			}
+
+			auto itr = std::lower_bound(mValues.begin(), mValues.end(), key, [](const TStore_Entry& e, TSymbol k) { return e.key < k; });
+			if (itr != mValues.end() && itr->key == key) {
+				*itr = std::move(entry);
+			}
+			else {
+				mValues.insert(itr, std::move(entry));
+			}
 		}
 
-		// retrieves a value from store
+		// retrieves a value from store; identifiers are resolved as constants, and a value missing in the store
+		// is looked up among constants under the same name
 		template<typename T>
-		T Get_Value(const std::string& key) const {
-			try {
-				auto& val = mValues.at(key);
-				if (val.type == NValue_Type::Identifier) {
-					return std::get<T>(sConsts.Get_Constant(std::get<std::string>(val.value)).value);
+		std::optional<T> Find_Value(TSymbol key) const {
+			if (auto* entry = Find_Entry(key)) {
+				if (entry->reference != Invalid_Symbol) {
+					if (auto val = Find_Constant<T>(entry->reference)) {
+						return val;
+					}
+				}
+				else if (auto* val = std::get_if<T>(&entry->value.value)) {
+					return *val;
 				}
-				return std::get<T>(mValues.at(key).value);
-			}
-			catch (...) {
-				return std::get<T>(sConsts.Get_Constant(key).value);
 			}
+
+			return Find_Constant<T>(key);
 		}
 
-		// merges two value stores into this instance
+		// merges two value stores into this instance (values already present are kept)
 		void Merge_With(const CValue_Store& other) {
-			for (auto& v : other.mValues) {
-				if (mValues.find(v.first) == mValues.end())
-					mValues[v.first] = v.second;
+			std::vector<TStore_Entry> merged;
+			merged.reserve(mValues.size() + other.mValues.size());
+
+			auto mine = mValues.begin();
+			for (auto& theirs : other.mValues) {
+				for (; mine != mValues.end() && mine->key < theirs.key; ++mine) {
+					merged.push_back(std::move(*mine));
+				}
+				if (mine == mValues.end() || mine->key != theirs.key) {
+					merged.push_back(theirs);
+				}
+			}
+			for (; mine != mValues.end(); ++mine) {
+				merged.push_back(std::move(*mine));
 			}
+
+			mValues = std::move(merged);
 		}
+
+		// stores are compared by their contents, so entities with the same values may share resolved data
+		auto operator<=>(const CValue_Store&) const = default;
 };
 
 /*
@@ -198,8 +231,8 @@ class CGeneric_Param_Wrapper {
 	public:
 		// retrieves value from the container
 		virtual TValue_Spec Get_Value() const = 0;
-		// sets the value to the container
-		virtual void Set_Value(const TValue_Spec& src) = 0;
+		// sets the value to the container; returns true, if the value changed
+		virtual bool Set_Value(const TValue_Spec& src) = 0;
 };
 
 /*
@@ -211,7 +244,9 @@ class CParam_Wrapper : public CGeneric_Param_Wrapper {
 		// an actual value; mutability is needed for lazyloading of actual values during runtime
 		mutable std::optional<T> mValue;
 		// attribute name to be used for value resolution
-		std::optional<std::string> mAttribute_Name;
+		TSymbol mAttribute_Name = Invalid_Symbol;
+		// was a failed resolution reported already? (to not flood the log every frame)
+		mutable bool mResolve_Reported = false;
 
 	public:
 		CParam_Wrapper() {};
@@ -223,7 +258,7 @@ class CParam_Wrapper : public CGeneric_Param_Wrapper {
 		}
 
 		// set attribute name to be used for resolution
-		void Set_Resolve_Key(const std::string& key) {
+		void Set_Resolve_Key(TSymbol key) {
 			mAttribute_Name = key;
 		}
 
@@ -232,23 +267,43 @@ class CParam_Wrapper : public CGeneric_Param_Wrapper {
 			return TValue_Spec{ NValue_Type::Identifier, mValue.value() };
 		}
 
-		// sets the value to the parameter
-		void Set_Value(const TValue_Spec& src) override {
+		// sets the value to the parameter; returns true, if the value changed (this serves as a dirty flag for frame deduplication)
+		bool Set_Value(const TValue_Spec& src) override {
+			bool changed = false;
 			// this is a rather tricky construction, that ensured the correct type of target variant
-			std::visit([this](auto&& val) {
-				if constexpr (std::is_same_v<std::remove_cvref_t<decltype(val)>, T>)
-					mValue = val;
+			std::visit([this, &changed](auto&& val) {
+				if constexpr (std::is_same_v<std::remove_cvref_t<decltype(val)>, T>) {
+					changed = Set_Typed_Value(val);
+				}
 			}, src.value);
+			return changed;
+		}
+
+		// retrieves an actual value of the parameter without any conversion
+		const T& Get_Typed_Value() const {
+			return mValue.value();
+		}
+
+		// sets the value of the parameter without any conversion; returns true, if the value changed
+		bool Set_Typed_Value(const T& value) {
+			const bool changed = !mValue.has_value() || mValue.value() != value;
+			mValue = value;
+			return changed;
 		}
 
 		// resolves a value of this parameter
-		template<typename TStore>
-		T Get_Value(const TStore& store) const {
+		T Get_Value(const CValue_Store& store) const {
 
-			if (mAttribute_Name.has_value()) {
-				mValue = store.Get_Value<T>(mAttribute_Name.value());
-				if (mValue.has_value())
+			if (mAttribute_Name != Invalid_Symbol) {
+				if (auto val = store.Find_Value<T>(mAttribute_Name)) {
+					mValue = val;
 					return mValue.value();
+				}
+
+				if (!mResolve_Reported) {
+					mResolve_Reported = true;
+					spdlog::error("Cannot resolve '{}' to a value of expected type", sSymbols.Get_Name(mAttribute_Name));
+				}
 			}
 
 			if (mValue.has_value()) {
@@ -259,6 +314,16 @@ class CParam_Wrapper : public CGeneric_Param_Wrapper {
 		}
 };
 
+/*
+ * Memory taken by scene entities - the storage every instance owns, and the storage shared by several instances
+ */
+struct TStorage_Usage {
+	size_t entities = 0;						// number of accounted entities
+	size_t instanceBytes = 0;					// bytes owned by the entities themselves
+	size_t sharedBytes = 0;						// bytes shared among the entities (counted once)
+	std::set<const void*> accountedShared;		// shared storage already counted
+};
+
 /*
  * A base class for all scene entities
  */
@@ -270,40 +335,67 @@ class CScene_Entity {
 	protected:
 		// value store used for parameter resolution
 		CValue_Store mDefault_Value_Store;
-		// set of resolvable attributes for runtime resolution
-		std::set<std::string> mResolvable_Attributes;
+		// resolvable attributes for runtime resolution (sorted, there are just a few of them)
+		std::vector<TSymbol> mResolvable_Attributes;
 		// reference to object, upon which the entity is invoked (e.g., animation)
-		std::optional<std::string> mObject_Reference;
-		// map of references to parameters; this is needed for e.g., animations
-		std::map<std::string, CGeneric_Param_Wrapper*> mParam_Reference;
+		std::optional<TSymbol> mObject_Reference;
+		// references to parameters by parameter name; this is needed for e.g., animations (an entity has just a few of them, so a vector is enough)
+		std::vector<std::pair<TSymbol, CGeneric_Param_Wrapper*>> mParam_Reference;
 
 		// register entity parameter and resolve its value, if possible
 		template<typename T, typename TTarget>
-		void Assign_Helper(const std::string& key, const std::map<std::string, TValue_Spec>& paramMap, TTarget& target) {
-			auto itr = paramMap.find(key);
-			if (itr != paramMap.end()) {
+		void Assign_Helper(TSymbol key, const CParams& params, TTarget& target) {
+			auto* val = params.Find_Parameter(key);
+			if (val) {
 				// store the parameter reference
-				mParam_Reference[key] = &target;
+				auto ritr = std::find_if(mParam_Reference.begin(), mParam_Reference.end(), [key](auto& ref) { return ref.first == key; });
+				if (ritr != mParam_Reference.end()) {
+					ritr->second = &target;
+				}
+				else {
+					mParam_Reference.push_back({ key, &target });
+				}
 				// if it is an identifier, postpone the resolution for later
-				if (itr->second.type == NValue_Type::Identifier) {
-					target.Set_Resolve_Key(std::get<std::string>(itr->second.value));
+				if (val->type == NValue_Type::Identifier) {
+					target.Set_Resolve_Key(val->symbol);
 				}
 				// otherwise try to resolve it immediatelly
 				else {
 					try {
-						target = std::get<T>(itr->second.value);
+						target = std::get<T>(val->value);
 					}
 					catch (std::bad_variant_access&) {
-						throw CInvalid_Parameter_Type(key);
+						throw CInvalid_Parameter_Type(sSymbols.Get_Name(key));
 					}
 				}
 			}
 		}
 
+		// retrieves the number of bytes allocated by the members of this base class
+		size_t Get_Base_Storage_Size() const {
+			return mDefault_Value_Store.Get_Storage_Size() + mResolvable_Attributes.capacity() * sizeof(TSymbol)
+				+ mParam_Reference.capacity() * sizeof(decltype(mParam_Reference)::value_type);
+		}
+
+		// points the reference to a parameter of the copied entity to the same parameter of this copy
+		void Rebind_Param(const CGeneric_Param_Wrapper& original, CGeneric_Param_Wrapper& copy) {
+			for (auto& ref : mParam_Reference) {
+				if (ref.second == &original) {
+					ref.second = &copy;
+				}
+			}
+		}
+
 	public:
 		explicit CScene_Entity(NEntity_Type type) : mType(type) {}
 		virtual ~CScene_Entity() = default;
 
+		// the parameter references of the copy still point to the parameters of the original; every class owning parameter
+		// wrappers has to rebind them in its copy constructor (see Rebind_Param)
+		CScene_Entity(const CScene_Entity& other) = default;
+
+		CScene_Entity& operator=(const CScene_Entity&) = delete;
+
 		// retrieves entity type
 		NEntity_Type Get_Type() const {
 			return mType;
@@ -315,9 +407,11 @@ class CScene_Entity {
 				return;
 			}
 
-			auto ats = attrs->Get_Attribute_List();
-			for (auto& at : ats) {
-				mResolvable_Attributes.insert(at);
+			for (TSymbol at : attrs->Get_Attribute_List()) {
+				auto itr = std::lower_bound(mResolvable_Attributes.begin(), mResolvable_Attributes.end(), at);
+				if (itr == mResolvable_Attributes.end() || *itr != at) {
+					mResolvable_Attributes.insert(itr, at);
+				}
 			}
 		}
 
@@ -327,26 +421,43 @@ class CScene_Entity {
 		}
 
 		// sets object reference upon which the entity is executed
-		void Set_Object_Reference(const std::string& objRef) {
+		void Set_Object_Reference(TSymbol objRef) {
 			mObject_Reference = objRef;
 		}
 
+		// retrieves object reference upon which the entity is executed
+		const std::optional<TSymbol>& Get_Object_Reference() const {
+			return mObject_Reference;
+		}
+
 		// retrieves a reference to parameter wrapper
-		CGeneric_Param_Wrapper* Get_Param_Ref(const std::string& refName) {
-			auto itr = mParam_Reference.find(refName);
+		CGeneric_Param_Wrapper* Get_Param_Ref(TSymbol refName) {
+			auto itr = std::find_if(mParam_Reference.begin(), mParam_Reference.end(), [refName](auto& ref) { return ref.first == refName; });
 			if (itr == mParam_Reference.end())
 				return nullptr;
 			return itr->second;
 		}
 
+		// retrieves the number of bytes owned by this entity (including its own allocations, excluding shared storage)
+		virtual size_t Get_Storage_Size() const {
+			return sizeof(CScene_Entity) + Get_Base_Storage_Size();
+		}
+		// adds the storage of the entity to the usage; shared storage is counted only once for all the entities sharing it
+		virtual void Account_Storage(TStorage_Usage& usage) const {
+			usage.entities++;
+			usage.instanceBytes += Get_Storage_Size();
+		}
+
 		// clones the entity (preferably deep clone)
 		virtual std::unique_ptr<CScene_Entity> Clone() const { return nullptr; }
 		// applies a body to the entity; this is needed for e.g., composite entities
 		virtual void Apply_Body(CCommand* command) { }
 		// applies parameters to the entity; every child should call the parent method, if possible, as the child extends parent's parameter block as well
 		virtual void Apply_Parameters(const CParams* params) = 0;
-		// executes the body of the entity to perform some action
-		virtual NExecution_Result Execute(CScene& scene) = 0;
+		// prepares the entity for rendering, once all its parameters and attributes are applied (called by the scene)
+		virtual void Prepare() { }
+		// executes the body of the entity to perform some action; waits and animations are not executed, the scene compiles them into its timeline
+		virtual NExecution_Result Execute(CScene& scene) { return NExecution_Result::Pass; }
 };
 
 /*
@@ -365,6 +476,7 @@ class CScene_Object : public CScene_Entity {
 
 	public:
 		explicit CScene_Object(NObject_Type type);
+		CScene_Object(const CScene_Object& other);
 		virtual ~CScene_Object();
 
 		// retrieves the X coordinate
@@ -375,12 +487,19 @@ class CScene_Object : public CScene_Entity {
 		double Get_Rotate() const;
 		// retrieves the object scale
 		double Get_Scale() const;
+		// retrieves the type of the object
+		NObject_Type Get_Object_Type() const;
+		// retrieves the world transformation of the object placed in a parent with given world transformation
+		CTransform Get_Transform(const CTransform& parent) const;
 
 		// default execution policy is to pass to next objects in the scene
 		NExecution_Result Execute(CScene& scene) override { return NExecution_Result::Pass; }
 
 		virtual void Apply_Parameters(const CParams* params) override;
-		virtual bool Render(BLContext& context, const CTransform& transform) const = 0;
+		// records the object into given frame snapshot; the parent is the world transformation of the parent object
+		virtual bool Render(CFrame_Snapshot& snapshot, const CTransform& parent) const = 0;
+		// retrieves conservative bounding box of the object in canvas coordinates, including stroke
+		virtual BLBox Get_Bounding_Box(const CTransform& parent) const = 0;
 };
 
 /*
@@ -396,4 +515,8 @@ class CBasic_Clonable_Scene_Object : public CScene_Object {
 			auto ptr = std::make_unique<T>(*static_cast<const T*>(this));
 			return ptr;
 		}
+
+		size_t Get_Storage_Size() const override {
+			return sizeof(T) + Get_Base_Storage_Size();
+		}
 };
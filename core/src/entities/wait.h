@@ -3,25 +3,30 @@
 #include "shared.h"
 
 /*
- * Wait synchronization entity
+ * Wait synchronization entity - the scene timeline lets the following entities enter only after the wait elapses
  */
 class CEntity_Wait : public CScene_Entity {
 	private:
 		// wait duration in milliseconds
 		CParam_Wrapper<int> mWait_Duration = 0;
 
-	protected:
-		// frame that is the first frame involved in waiting
-		std::optional<size_t> mSuspend_Frame;
-
 	public:
 		CEntity_Wait() : CScene_Entity(NEntity_Type::Wait) {}
+		CEntity_Wait(const CEntity_Wait& other) : CScene_Entity(other), mWait_Duration(other.mWait_Duration) {
+			Rebind_Param(other.mWait_Duration, mWait_Duration);
+		}
 
 		std::unique_ptr<CScene_Entity> Clone() const override {
 			auto ptr = std::make_unique<CEntity_Wait>(*this);
 			return ptr;
 		}
 
+		size_t Get_Storage_Size() const override {
+			return sizeof(CEntity_Wait) + Get_Base_Storage_Size();
+		}
+
 		void Apply_Parameters(const CParams* params) override;
-		NExecution_Result Execute(CScene& scene) override;
+
+		// retrieves the wait duration in frames
+		size_t Get_Duration_Frames() const;
 };
@@ -1,36 +1,36 @@
 #include "factory.h"
 
-#include <algorithm>
-#include <string>
-
 #include <spdlog/spdlog.h>
 
 CFactory::CFactory() {
-	Register_Factory<CRectangle>("rectangle");
-	Register_Factory<CCircle>("circle");
-	Register_Factory<CComposite>("composite");
-	Register_Factory<CEntity_Wait>("wait");
-	Register_Factory<CEntity_Animate>("animate");
+	Register_Factory<CRectangle>(Symbols::Rectangle);
+	Register_Factory<CCircle>(Symbols::Circle);
+	Register_Factory<CComposite>(Symbols::Composite);
+	Register_Factory<CEntity_Wait>(Symbols::Wait);
+	Register_Factory<CEntity_Animate>(Symbols::Animate);
 }
 
-std::unique_ptr<CScene_Entity> CFactory::Create(const std::string& name) {
-
-	std::string namecopy(name);
-	std::transform(namecopy.begin(), namecopy.end(), namecopy.begin(), [](char c) { return std::tolower(c); });
+std::unique_ptr<CScene_Entity> CFactory::Create(TSymbol name) const {
 
-	if (mFactories.find(namecopy) == mFactories.end()) {
+	auto fitr = mFactories.find(name);
+	if (fitr == mFactories.end()) {
 
-		if (mPrototypes.find(namecopy) == mPrototypes.end()) {
-			spdlog::warn("Cannot find a factory for object with name '{}'", namecopy);
+		auto pitr = mPrototypes.find(name);
+		if (pitr == mPrototypes.end()) {
+			spdlog::warn("Cannot find a factory for object with name '{}'", sSymbols.Get_Name(name));
 			return nullptr;
 		}
 
-		return mPrototypes[namecopy]->Clone();
+		return pitr->second->Clone();
 	}
 
-	return mFactories[namecopy]();
+	return fitr->second();
 }
 
-void CFactory::Register_Prototype(const std::string& name, std::unique_ptr<CScene_Entity>&& prototype) {
+void CFactory::Register_Prototype(TSymbol name, std::unique_ptr<CScene_Entity>&& prototype) {
 	mPrototypes[name] = std::move(prototype);
 }
+
+void CFactory::Clear_Prototypes() {
+	mPrototypes.clear();
+}
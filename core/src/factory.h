@@ -11,13 +11,16 @@
 
 /*
  * Entity factory class
+ *
+ * Factories and prototypes are registered only while parsing the input; after that, the factory is read-only,
+ * so entities may be created from multiple threads
  */
 class CFactory {
 	private:
 		// scene entity factory for built-in objects
-		std::map<std::string, std::function<std::unique_ptr<CScene_Entity>()>> mFactories;
+		std::map<TSymbol, std::function<std::unique_ptr<CScene_Entity>()>> mFactories;
 		// prototypes builder - stores a template, that gets cloned upon request
-		std::map<std::string, std::unique_ptr<CScene_Entity>> mPrototypes;
+		std::map<TSymbol, std::unique_ptr<CScene_Entity>> mPrototypes;
 
 		// private singleton constructor to avoid multiple instantiation
 		CFactory();
@@ -31,16 +34,18 @@ class CFactory {
 
 		// registers a factory for a given object type (built-in types)
 		template<typename T>
-		void Register_Factory(const std::string& name) {
+		void Register_Factory(TSymbol name) {
 			mFactories[name] = []() -> std::unique_ptr<CScene_Entity> {
 				return std::make_unique<T>();
 			};
 		}
 
 		// registers a prototype template
-		void Register_Prototype(const std::string& name, std::unique_ptr<CScene_Entity>&& prototype);
-		// creates an entity based on given name
-		std::unique_ptr<CScene_Entity> Create(const std::string& name);
+		void Register_Prototype(TSymbol name, std::unique_ptr<CScene_Entity>&& prototype);
+		// removes all registered prototypes
+		void Clear_Prototypes();
+		// creates an entity based on given name (case-folded symbol)
+		std::unique_ptr<CScene_Entity> Create(TSymbol name) const;
 };
 
 #define sFactory CFactory::Instance()
@@ -0,0 +1,132 @@
+#include "input_buffer.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+namespace {
+	// size of a single read from a stream, that cannot be mapped
+	constexpr size_t Read_Chunk_Size = 1 << 20;
+}
+
+CInput_Buffer::~CInput_Buffer() {
+#ifndef _WIN32
+	if (mMapped_Size > 0) {
+		munmap(mData, mMapped_Size);
+	}
+#endif
+}
+
+std::unique_ptr<CInput_Buffer> CInput_Buffer::Open(const std::filesystem::path& path) {
+
+	std::unique_ptr<CInput_Buffer> buffer(new CInput_Buffer());
+
+	if (path == "-") {
+		if (!buffer->Read_Stream(stdin)) {
+			spdlog::error("Cannot read the input from the standard input");
+			return nullptr;
+		}
+		return buffer;
+	}
+
+	if (buffer->Map_File(path)) {
+		return buffer;
+	}
+
+	// pipes, special files and empty files cannot be mapped, but they may still be read
+	std::FILE* file = std::fopen(path.string().c_str(), "rb");
+	if (!file) {
+		spdlog::error("Cannot open the input file {}", path.string());
+		return nullptr;
+	}
+
+	const bool ok = buffer->Read_Stream(file);
+	std::fclose(file);
+
+	if (!ok) {
+		spdlog::error("Cannot read the input file {}", path.string());
+		return nullptr;
+	}
+
+	return buffer;
+}
+
+bool CInput_Buffer::Map_File(const std::filesystem::path& path) {
+#ifdef _WIN32
+	return false;
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	const size_t size = static_cast<size_t>(st.st_size);
+	const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t total = ((size + 2 + page - 1) / page) * page;
+
+	// reserve zeroed memory for the file and the terminators first; when the file fills its last page exactly, the terminators
+	// land in the anonymous page behind it, otherwise in the zero-filled rest of the last file page
+	void* area = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+
+	// the mapping is private, so the scanner may temporarily terminate tokens in place without touching the file
+	void* mapped = mmap(area, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+	close(fd);
+
+	if (mapped == MAP_FAILED) {
+		munmap(area, total);
+		return false;
+	}
+
+	madvise(area, size, MADV_SEQUENTIAL);
+
+	mData = static_cast<char*>(area);
+	mSize = size;
+	mMapped_Size = total;
+
+	return true;
+#endif
+}
+
+bool CInput_Buffer::Read_Stream(std::FILE* file) {
+
+	size_t size = 0;
+
+	while (true) {
+		mStorage.resize(size + Read_Chunk_Size);
+
+		const size_t count = std::fread(mStorage.data() + size, 1, Read_Chunk_Size, file);
+		size += count;
+
+		if (count < Read_Chunk_Size) {
+			break;
+		}
+	}
+
+	if (std::ferror(file)) {
+		return false;
+	}
+
+	mStorage.resize(size);
+	mStorage.push_back('\0');
+	mStorage.push_back('\0');
+
+	mData = mStorage.data();
+	mSize = size;
+
+	return true;
+}
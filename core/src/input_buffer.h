@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <filesystem>
+
+/*
+ * Input text prepared for the scanner - writable, and terminated by two NUL characters (as required by yy_scan_buffer)
+ *
+ * Regular files are memory mapped (copy-on-write), so they are neither read ahead of the scanner nor copied; the standard
+ * input (and files on platforms without mapping support) are read in large chunks into a heap buffer
+ */
+class CInput_Buffer {
+	private:
+		// start of the text
+		char* mData = nullptr;
+		// length of the text without the terminators
+		size_t mSize = 0;
+		// length of the mapped area (0 if the text is not mapped)
+		size_t mMapped_Size = 0;
+		// storage of text, that is not mapped
+		std::string mStorage;
+
+		CInput_Buffer() = default;
+
+		// maps given file; returns false if the mapping is not possible
+		bool Map_File(const std::filesystem::path& path);
+		// reads the whole stream in chunks
+		bool Read_Stream(std::FILE* file);
+
+	public:
+		~CInput_Buffer();
+
+		CInput_Buffer(const CInput_Buffer&) = delete;
+		CInput_Buffer& operator=(const CInput_Buffer&) = delete;
+
+		// opens given file, or the standard input if the path is "-"; returns nullptr on failure
+		static std::unique_ptr<CInput_Buffer> Open(const std::filesystem::path& path);
+
+		// retrieves the text followed by the two terminators
+		char* Get_Data() {
+			return mData;
+		}
+
+		// retrieves the length of the text (without the terminators)
+		size_t Get_Size() const {
+			return mSize;
+		}
+
+		// is the text mapped directly from the file?
+		bool Is_Mapped() const {
+			return mMapped_Size > 0;
+		}
+};
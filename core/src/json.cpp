@@ -0,0 +1,27 @@
+#include "json.h"
+
+#include <format>
+
+std::string Escape_JSON(std::string_view str) {
+	std::string out;
+	out.reserve(str.size());
+
+	for (char c : str) {
+		switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					out += std::format("\\u{:04x}", static_cast<int>(c));
+				}
+				else {
+					out += c;
+				}
+				break;
+		}
+	}
+
+	return out;
+}
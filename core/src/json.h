@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// escapes a string to be written as a JSON string (without the enclosing quotes)
+std::string Escape_JSON(std::string_view str);
@@ -14,3 +14,19 @@
 #include "entities/composite.h"
 #include "entities/rectangle.h"
 #include "entities/wait.h"
+
+// calls given function with the object cast to its concrete type; the object type tag replaces dynamic_cast in the render loop,
+// and as the concrete classes are final, the calls made by the function are not virtual
+template<typename TFunc>
+decltype(auto) Visit_Object(const CScene_Object& obj, TFunc&& func) {
+	switch (obj.Get_Object_Type()) {
+		case NObject_Type::Rectangle:
+			return func(static_cast<const CRectangle&>(obj));
+		case NObject_Type::Circle:
+			return func(static_cast<const CCircle&>(obj));
+		case NObject_Type::Composite:
+			return func(static_cast<const CComposite&>(obj));
+		default:
+			return func(obj);
+	}
+}
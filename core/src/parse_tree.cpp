@@ -0,0 +1,34 @@
+#include "parse_tree.h"
+#include "vdlang_lex.h"
+#include "vdlang_parser.h"
+
+#include <spdlog/spdlog.h>
+
+CParse_Tree::CParse_Tree(std::unique_ptr<CInput_Buffer> input) : mInput(std::move(input)), mArena(std::max<size_t>(mInput->Get_Size(), 4096)), mBlocks(&mArena) {
+	//
+}
+
+bool CParse_Tree::Parse() {
+	// the buffer is scanned in place (no copy); its size includes the two terminators
+	YY_BUFFER_STATE state = yy_scan_buffer(mInput->Get_Data(), mInput->Get_Size() + 2);
+	if (!state) {
+		spdlog::error("Cannot set up the scanner buffer");
+		return false;
+	}
+
+	const int result = yyparse(*this);
+
+	yy_delete_buffer(state);
+
+	return result == 0 && !mFailed;
+}
+
+void CParse_Tree::Add_Block(CBlock* block) {
+	block->Set_Block_Index(mBlock_Counter++);
+	mBlocks.push_back(block);
+}
+
+void CParse_Tree::Report_Error(const char* message) {
+	spdlog::error("Syntax error: {}", message);
+	mFailed = true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include <algorithm>
+#include <new>
+#include <memory>
+
+#include "parser_entities.h"
+#include "input_buffer.h"
+
+/*
+ * Result of a single parser run - owns the input text, all the parse tree nodes and the arena they are allocated from
+ *
+ * Values parsed from the input refer to the input text instead of copying it, and the nodes are never freed one by one;
+ * everything is released at once when the tree is destroyed, so the tree must outlive everything built from its blocks
+ */
+class CParse_Tree {
+	private:
+		// input text, scanned in place
+		std::unique_ptr<CInput_Buffer> mInput;
+		// arena all the nodes are allocated from
+		std::pmr::monotonic_buffer_resource mArena;
+		// parsed blocks in the order the parser finished them
+		std::pmr::vector<CBlock*> mBlocks;
+		// index assigned to the next finished block
+		size_t mBlock_Counter = 0;
+		// was there a syntax error?
+		bool mFailed = false;
+
+	public:
+		// takes over the input text to be parsed
+		explicit CParse_Tree(std::unique_ptr<CInput_Buffer> input);
+
+		CParse_Tree(const CParse_Tree&) = delete;
+		CParse_Tree& operator=(const CParse_Tree&) = delete;
+
+		// runs the scanner and parser over the input; returns false on syntax error
+		bool Parse();
+
+		// allocates a parse tree node in the arena; the node destructor is never called, so it must not own anything outside the arena
+		template<typename T, typename... Args>
+		T* Create(Args&&... args) {
+			return new (mArena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		// retrieves the arena, so the node containers may allocate from it
+		std::pmr::memory_resource* Get_Arena() {
+			return &mArena;
+		}
+
+		// registers a finished top level block
+		void Add_Block(CBlock* block);
+		// records a syntax error reported by the parser
+		void Report_Error(const char* message);
+
+		// retrieves all parsed blocks
+		std::pmr::vector<CBlock*>& Get_Blocks() {
+			return mBlocks;
+		}
+
+		// retrieves the parsed text (without the scanner terminators)
+		std::string_view Get_Input() const {
+			return std::string_view(mInput->Get_Data(), mInput->Get_Size());
+		}
+};
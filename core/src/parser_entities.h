@@ -1,11 +1,14 @@
 #pragma once
 
-#include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <optional>
-#include <list>
+#include <algorithm>
+#include <memory_resource>
+
+#include "symbols.h"
 
 enum class NBlock_Type {
 	Config,
@@ -24,113 +27,146 @@ enum class NValue_Type {
 
 using rgb_t = uint32_t;
 
+// a piece of the parsed input; a plain structure, so the lexer may pass it through the parser value union
+struct TSource_Text {
+	const char* data;
+	size_t length;
+
+	std::string_view View() const {
+		return std::string_view(data, length);
+	}
+};
+
+// strings are views to the symbol table (identifiers and string literals are interned), so the values may outlive the parse
+// tree and the input, e.g. in prototypes, constants and cached draw lists
 struct TValue_Spec {
 	NValue_Type type = NValue_Type::Float;
-	std::variant<int, double, rgb_t, std::string> value;
+	std::variant<int, double, rgb_t, std::string_view> value;
+	TSymbol symbol = Invalid_Symbol;		// interned name, if the value is an identifier or a string
+
+	auto operator<=>(const TValue_Spec&) const = default;
 };
 
 struct TParam_Entry {
-	std::string key;
+	TSymbol key = Invalid_Symbol;
 	TValue_Spec value;
+
+	auto operator<=>(const TParam_Entry&) const = default;
 };
 
+// parameters sorted by key; a copy is allocated from the default resource, even if the original lives in a parse arena
 class CParams {
 	private:
-		std::map<std::string, TValue_Spec> mParameters;
+		std::pmr::vector<TParam_Entry> mParameters;
 
 	public:
-		template<typename T>
-		void Add_Parameter(NValue_Type type, const std::string& key, T&& value) {
-			mParameters[key] = {
-				type,
-				value
-			};
-		}
+		CParams() = default;
+		explicit CParams(std::pmr::memory_resource* resource) : mParameters(resource) {}
 
-		void Add_Parameter(TParam_Entry* entry) {
-			mParameters[entry->key] = entry->value;
+		void Add_Parameter(const TParam_Entry& entry) {
+			auto itr = std::lower_bound(mParameters.begin(), mParameters.end(), entry.key, [](const TParam_Entry& p, TSymbol k) { return p.key < k; });
+			if (itr != mParameters.end() && itr->key == entry.key) {
+				itr->value = entry.value;
+			}
+			else {
+				mParameters.insert(itr, entry);
+			}
 		}
 
 		void Merge_To(CParams* target) const {
 			for (auto& p : mParameters) {
-				target->mParameters[p.first] = p.second;
+				target->Add_Parameter(p);
 			}
 		}
 
-		void Remove_Parameter(const std::string& key) {
-			mParameters.erase(key);
+		void Remove_Parameter(TSymbol key) {
+			auto itr = std::lower_bound(mParameters.begin(), mParameters.end(), key, [](const TParam_Entry& p, TSymbol k) { return p.key < k; });
+			if (itr != mParameters.end() && itr->key == key) {
+				mParameters.erase(itr);
+			}
 		}
 
-		const std::map<std::string, TValue_Spec>& Get_Parameters() const {
+		const TValue_Spec* Find_Parameter(TSymbol key) const {
+			auto itr = std::lower_bound(mParameters.begin(), mParameters.end(), key, [](const TParam_Entry& p, TSymbol k) { return p.key < k; });
+			return (itr != mParameters.end() && itr->key == key) ? &itr->value : nullptr;
+		}
+
+		const std::pmr::vector<TParam_Entry>& Get_Parameters() const {
 			return mParameters;
 		}
+
+		// retrieves the number of bytes allocated for the parameters
+		size_t Get_Storage_Size() const {
+			return mParameters.capacity() * sizeof(TParam_Entry);
+		}
+
+		auto operator<=>(const CParams& other) const {
+			return std::lexicographical_compare_three_way(mParameters.begin(), mParameters.end(), other.mParameters.begin(), other.mParameters.end());
+		}
+
+		bool operator==(const CParams& other) const {
+			return mParameters == other.mParameters;
+		}
 };
 
 class CAttributes {
 	private:
-		std::list<std::string> mAttributes;
+		std::pmr::vector<TSymbol> mAttributes;
 
 	public:
-		void Add_Attribute(const std::string& param) {
+		explicit CAttributes(std::pmr::memory_resource* resource) : mAttributes(resource) {}
+
+		void Add_Attribute(TSymbol param) {
 			mAttributes.push_back(param);
 		}
 
 		void Merge_To(CAttributes* target) {
-			for (auto& p : mAttributes) {
-				target->mAttributes.push_front(p);
-			}
+			target->mAttributes.insert(target->mAttributes.end(), mAttributes.begin(), mAttributes.end());
 		}
 
-		const std::list<std::string>& Get_Attribute_List() const {
+		const std::pmr::vector<TSymbol>& Get_Attribute_List() const {
 			return mAttributes;
 		}
 };
 
+// parse tree nodes are allocated from the parse arena and released all at once with it, so they are never deleted one by one
 class CCommand {
 	private:
-		std::string mIdentifier;
-		std::string mEntity_Name;
-		std::string mObject_Reference;
+		TSymbol mIdentifier = Invalid_Symbol;
+		TSymbol mEntity_Name = Invalid_Symbol;
+		TSymbol mObject_Reference = Invalid_Symbol;
 		CParams* mParams = nullptr;
 		CAttributes* mAttributes = nullptr;
 		std::optional<TValue_Spec> mValue;
 
-		std::list<CCommand*> mSubcommands;
+		std::pmr::vector<CCommand*> mSubcommands;
 
 	public:
-		CCommand() {
+		explicit CCommand(std::pmr::memory_resource* resource) : mSubcommands(resource) {
 			//
 		}
 
-		~CCommand() {
-			if (mParams)
-				delete mParams;
-
-			if (mAttributes)
-				delete mAttributes;
-		}
-
-		void Set_Identifier(const std::string& identifier) {
+		void Set_Identifier(TSymbol identifier) {
 			mIdentifier = identifier;
 		}
 
-		const std::string& Get_Identifier() const {
+		TSymbol Get_Identifier() const {
 			return mIdentifier;
 		}
 
-		void Set_Object_Reference(const std::string& objRef) {
+		void Set_Object_Reference(TSymbol objRef) {
 			mObject_Reference = objRef;
 		}
 
-		const std::string& Get_Object_Reference() const {
+		TSymbol Get_Object_Reference() const {
 			return mObject_Reference;
 		}
 
-		void Set_Entity_Name(const std::string& entityName) {
+		void Set_Entity_Name(TSymbol entityName) {
 			mEntity_Name = entityName;
 		}
 
-		const std::string& Get_Entity_Name() const {
+		TSymbol Get_Entity_Name() const {
 			return mEntity_Name;
 		}
 
@@ -143,9 +179,6 @@ class CCommand {
 		}
 
 		void Set_Params(CParams* params) {
-			if (mParams)
-				delete mParams;
-
 			mParams = params;
 		}
 
@@ -154,9 +187,6 @@ class CCommand {
 		}
 
 		void Set_Attributes(CAttributes* attrs) {
-			if (mAttributes)
-				delete mAttributes;
-
 			mAttributes = attrs;
 		}
 
@@ -165,10 +195,10 @@ class CCommand {
 		}
 
 		void Add_Command(CCommand* command) {
-			mSubcommands.push_front(command);
+			mSubcommands.push_back(command);
 		}
 
-		const std::list<CCommand*>& Get_Subcommands() const {
+		const std::pmr::vector<CCommand*>& Get_Subcommands() const {
 			return mSubcommands;
 		}
 };
@@ -185,23 +215,11 @@ class CBlock {
 			//
 		}
 
-		~CBlock() {
-			if (mParams)
-				delete mParams;
-			if (mContent)
-				delete mContent;
-		}
-
 		void Set_Params(CParams* params) {
-			if (mParams)
-				delete mParams;
-
 			mParams = params;
 		}
 
 		void Set_Command(CCommand* cmd) {
-			if (mContent)
-				delete mContent;
 			mContent = cmd;
 		}
 
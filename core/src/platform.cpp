@@ -0,0 +1,61 @@
+#include "platform.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#include <mach/mach.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
+#endif
+
+size_t Get_Peak_Memory_Usage() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return static_cast<size_t>(counters.PeakWorkingSetSize);
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	// macOS reports the value in bytes
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	// Linux reports the value in kilobytes
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+size_t Get_Current_Memory_Usage() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return static_cast<size_t>(counters.WorkingSetSize);
+	}
+	return 0;
+#elif defined(__APPLE__)
+	mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+		return 0;
+	}
+	return static_cast<size_t>(info.resident_size);
+#else
+	// the second field is the number of resident pages
+	std::ifstream statm("/proc/self/statm");
+	size_t total = 0, resident = 0;
+	if (!(statm >> total >> resident)) {
+		return 0;
+	}
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
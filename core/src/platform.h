@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// retrieves peak resident memory (working set) of the process in bytes; returns 0 if not supported
+size_t Get_Peak_Memory_Usage();
+// retrieves current resident memory (working set) of the process in bytes; returns 0 if not supported
+size_t Get_Current_Memory_Usage();
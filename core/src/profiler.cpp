@@ -0,0 +1,161 @@
+#include "profiler.h"
+#include "json.h"
+
+#include <fstream>
+#include <format>
+#include <map>
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+	// maximum number of events kept for the trace per thread; per-object events of long videos would take gigabytes otherwise
+	constexpr size_t Max_Trace_Events = 1 << 20;
+}
+
+CProfiler::CProfiler() {
+	mOrigin = std::chrono::steady_clock::now();
+}
+
+void CProfiler::Enable() {
+	mOrigin = std::chrono::steady_clock::now();
+	mEnabled = true;
+}
+
+uint64_t CProfiler::Now() const {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mOrigin).count());
+}
+
+TProfile_Thread& CProfiler::Get_Thread_Buffer() {
+
+	// the buffer is shared with the profiler, so it outlives the thread
+	thread_local std::shared_ptr<TProfile_Thread> buffer;
+
+	if (!buffer) {
+		buffer = std::make_shared<TProfile_Thread>();
+
+		std::unique_lock lck(mMutex);
+		buffer->id = static_cast<uint32_t>(mThreads.size()) + 1;
+		buffer->name = std::format("Thread {}", buffer->id);
+		mThreads.push_back(buffer);
+	}
+
+	return *buffer;
+}
+
+void CProfiler::Record(const char* name, const char* category, uint64_t start, uint64_t end) {
+	auto& buffer = Get_Thread_Buffer();
+	const uint64_t duration = end - start;
+
+	auto& st = buffer.stats[{ category, name }];
+	st.count++;
+	st.total += duration;
+	st.max = std::max(st.max, duration);
+
+	if (buffer.events.size() >= Max_Trace_Events) {
+		buffer.dropped++;
+		return;
+	}
+
+	buffer.events.push_back({ name, category, start, duration });
+}
+
+const char* CProfiler::Intern_Name(std::string_view name) {
+	std::unique_lock lck(mNames_Mutex);
+	return mNames.emplace(name).first->c_str();
+}
+
+void CProfiler::Set_Thread_Name(const std::string& name) {
+	if (!Is_Enabled()) {
+		return;
+	}
+
+	auto& buffer = Get_Thread_Buffer();
+
+	std::unique_lock lck(mMutex);
+	buffer.name = name;
+}
+
+bool CProfiler::Write_Trace(const std::filesystem::path& path) const {
+
+	std::ofstream out(path, std::ios::out | std::ios::binary);
+	if (!out) {
+		spdlog::error("Cannot open trace file {}", path.string());
+		return false;
+	}
+
+	std::unique_lock lck(mMutex);
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	for (auto& thr : mThreads) {
+		out << std::format("{}{{\"ph\":\"M\",\"pid\":1,\"tid\":{},\"name\":\"thread_name\",\"args\":{{\"name\":\"{}\"}}}}", first ? "" : ",\n", thr->id, Escape_JSON(thr->name));
+		first = false;
+
+		for (auto& ev : thr->events) {
+			out << std::format(",\n{{\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{},\"dur\":{},\"cat\":\"{}\",\"name\":\"{}\"}}", thr->id, ev.start, ev.duration, ev.category, Escape_JSON(ev.name));
+		}
+	}
+
+	out << "\n]}\n";
+
+	size_t dropped = 0;
+	for (auto& thr : mThreads) {
+		dropped += thr->dropped;
+	}
+	if (dropped > 0) {
+		spdlog::warn("The trace is incomplete, {} events over the limit of {} per thread were left out", dropped, Max_Trace_Events);
+	}
+
+	if (!out) {
+		spdlog::error("Cannot write trace file {}", path.string());
+		return false;
+	}
+
+	spdlog::info("Trace written to {}", path.string());
+
+	return true;
+}
+
+void CProfiler::Print_Summary(size_t topCount) const {
+
+	std::map<std::string, TProfile_Stats> categories;
+	std::map<std::pair<std::string, std::string>, TProfile_Stats> events;
+
+	{
+		std::unique_lock lck(mMutex);
+
+		// the same name may come from different pointers (e.g., literals in different translation units), so they are merged by value
+		for (auto& thr : mThreads) {
+			for (auto& [key, src] : thr->stats) {
+				for (TProfile_Stats* st : { &categories[key.first], &events[{ key.first, key.second }] }) {
+					st->count += src.count;
+					st->total += src.total;
+					st->max = std::max(st->max, src.max);
+				}
+			}
+		}
+	}
+
+	auto print = [](const std::string& label, const TProfile_Stats& st) {
+		spdlog::info("  {:<48} {:>10} {:>12.3f} {:>12.3f} {:>12.3f}", label, st.count, static_cast<double>(st.total) / 1000.0,
+			static_cast<double>(st.total) / 1000.0 / static_cast<double>(std::max(st.count, static_cast<size_t>(1))), static_cast<double>(st.max) / 1000.0);
+	};
+
+	spdlog::info("Profile summary (times in ms; nested events are included in their parents):");
+	spdlog::info("  {:<48} {:>10} {:>12} {:>12} {:>12}", "category", "count", "total", "average", "max");
+	for (auto& [cat, st] : categories) {
+		print(cat, st);
+	}
+
+	// the most expensive individual events (objects, animations, ...) point to the culprit of a slow scene
+	std::vector<std::pair<std::pair<std::string, std::string>, TProfile_Stats>> sorted(events.begin(), events.end());
+	std::sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.second.total > b.second.total; });
+	sorted.resize(std::min(sorted.size(), topCount));
+
+	spdlog::info("  {:<48} {:>10} {:>12} {:>12} {:>12}", "event", "count", "total", "average", "max");
+	for (auto& [key, st] : sorted) {
+		print(key.first + ": " + key.second, st);
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+/*
+ * A single recorded interval
+ */
+struct TProfile_Event {
+	const char* name = "";			// event name (e.g., object identifier); static or interned by the profiler
+	const char* category = "";		// event category (e.g., phase or object type)
+	uint64_t start = 0;				// start time in microseconds since the profiler was enabled
+	uint64_t duration = 0;			// duration in microseconds
+};
+
+/*
+ * Aggregated statistics of a group of events
+ */
+struct TProfile_Stats {
+	size_t count = 0;				// number of events
+	uint64_t total = 0;				// total duration in microseconds
+	uint64_t max = 0;				// longest duration in microseconds
+};
+
+/*
+ * Events recorded by a single thread
+ */
+struct TProfile_Thread {
+	// hashes the category and name pointers; both are static or interned, so equal names mostly share the pointer
+	struct TKey_Hash {
+		size_t operator()(const std::pair<const char*, const char*>& key) const {
+			return std::hash<const char*>{}(key.first) ^ (std::hash<const char*>{}(key.second) * 31);
+		}
+	};
+
+	uint32_t id = 0;						// sequential thread identifier
+	std::string name;						// thread name shown in the trace
+	std::vector<TProfile_Event> events;		// recorded events (up to the trace limit); written only by the owning thread
+	size_t dropped = 0;						// number of events left out of the trace, as the limit was reached
+	// statistics of all recorded events (including the dropped ones) by category and name
+	std::unordered_map<std::pair<const char*, const char*>, TProfile_Stats, TKey_Hash> stats;
+};
+
+/*
+ * Instrumentation profiler - collects timed intervals from all threads, so they may be exported as a Chrome/Perfetto trace
+ * or summarized; when disabled, recording a scope costs a single atomic load
+ *
+ * Every thread records to its own buffer without locking; the buffers are read only after all the recording threads finished
+ */
+class CProfiler {
+	private:
+		// is the profiler recording?
+		std::atomic<bool> mEnabled{ false };
+		// time all the events are relative to
+		std::chrono::steady_clock::time_point mOrigin;
+
+		// guards the thread list
+		mutable std::mutex mMutex;
+		// buffers of all threads, that recorded anything
+		std::vector<std::shared_ptr<TProfile_Thread>> mThreads;
+
+		// guards the interned names
+		std::mutex mNames_Mutex;
+		// interned event names; the set nodes are never moved, so the names stay valid
+		std::unordered_set<std::string> mNames;
+
+		// private singleton constructor to avoid multiple instantiation
+		CProfiler();
+
+	protected:
+		// retrieves the buffer of the calling thread, registers it on the first call
+		TProfile_Thread& Get_Thread_Buffer();
+
+	public:
+		// static singleton retrieval method
+		static CProfiler& Instance() {
+			static CProfiler gInstance;
+			return gInstance;
+		}
+
+		// starts recording; all event times are relative to this call
+		void Enable();
+		// is the profiler recording?
+		bool Is_Enabled() const {
+			return mEnabled.load(std::memory_order_relaxed);
+		}
+
+		// retrieves current time in microseconds since the profiler was enabled
+		uint64_t Now() const;
+		// records a finished interval for the calling thread; the name must be static or interned (see Intern_Name)
+		void Record(const char* name, const char* category, uint64_t start, uint64_t end);
+		// retrieves a copy of given name, that stays valid as long as the profiler; meant for names built at runtime
+		const char* Intern_Name(std::string_view name);
+		// names the calling thread in the trace
+		void Set_Thread_Name(const std::string& name);
+
+		// writes all recorded events as a Chrome trace (JSON), that can be opened in chrome://tracing or Perfetto
+		bool Write_Trace(const std::filesystem::path& path) const;
+		// logs a summary table of the recorded events - totals per category and the most expensive events
+		void Print_Summary(size_t topCount = 20) const;
+};
+
+#define sProfiler CProfiler::Instance()
+
+/*
+ * Scoped timer - records the interval from its construction to its destruction
+ */
+class CProfile_Scope {
+	private:
+		// event name
+		const char* mName;
+		// event category
+		const char* mCategory;
+		// start time
+		uint64_t mStart = 0;
+		// is the scope being recorded?
+		bool mActive = false;
+
+	public:
+		// the name must be static or interned (see CProfiler::Intern_Name)
+		CProfile_Scope(const char* category, const char* name) : mName(name), mCategory(category) {
+			if (sProfiler.Is_Enabled()) {
+				mActive = true;
+				mStart = sProfiler.Now();
+			}
+		}
+
+		~CProfile_Scope() {
+			if (mActive) {
+				sProfiler.Record(mName, mCategory, mStart, sProfiler.Now());
+			}
+		}
+
+		CProfile_Scope(const CProfile_Scope&) = delete;
+		CProfile_Scope& operator=(const CProfile_Scope&) = delete;
+};
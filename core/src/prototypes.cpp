@@ -13,14 +13,11 @@ bool CPrototypes::Build(CBlock* block) {
 	for (auto& sc : block->Get_Content()->Get_Subcommands()) {
 		auto name = sc->Get_Entity_Name();
 
-		if (sc->Get_Identifier().empty()) {
+		if (sc->Get_Identifier() == Invalid_Symbol) {
 			spdlog::error("Prototype must have an identifier");
 			return false;
 		}
 
-		std::string namecopy(sc->Get_Identifier());
-		std::transform(namecopy.begin(), namecopy.end(), namecopy.begin(), [](char c) { return std::tolower(c); });
-
 		auto obj = sFactory.Create(name);
 
 		if (!sc->Get_Subcommands().empty()) {
@@ -35,16 +32,21 @@ bool CPrototypes::Build(CBlock* block) {
 			obj->Apply_Attribute_Block(sc->Get_Attributes());
 		}
 
-		if (!sc->Get_Object_Reference().empty()) {
+		if (sc->Get_Object_Reference() != Invalid_Symbol) {
 			obj->Set_Object_Reference(sc->Get_Object_Reference());
 		}
 
-		sFactory.Register_Prototype(namecopy, std::move(obj));
+		sFactory.Register_Prototype(sc->Get_Identifier(), std::move(obj));
 	}
 
 	return true;
 }
 
+void CPrototypes::Reset() {
+	sFactory.Clear_Prototypes();
+	mInitialized = false;
+}
+
 bool CPrototypes::Is_Initialized() const {
 	return mInitialized;
 }
@@ -22,6 +22,8 @@ class CPrototypes {
 
 		// build prototypes store from given prototypes block
 		bool Build(CBlock* block);
+		// removes all prototypes from the factory, so another input may be built (must not be called while rendering)
+		void Reset();
 		// is the store properly initialized?
 		bool Is_Initialized() const;
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <blend2d.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VIDGENX_AFFINE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VIDGENX_AFFINE_NEON
+#endif
+
+/*
+ * Affine matrix kernels - every row of the result is a combination of two rows of the right matrix (plus its translation),
+ * so a row fits a single 2-lane double vector; a scalar fallback is used, where SSE2 or NEON is not available
+ *
+ * The matrix is expected to be laid out as m00, m01, m10, m11, m20, m21, which is the layout of BLMatrix2D
+ */
+
+// multiplies two affine matrices; the result applies the first matrix, then the second one (as BLMatrix2D::postTransform)
+inline void Multiply_Affine(const BLMatrix2D& a, const BLMatrix2D& b, BLMatrix2D& out) {
+#if defined(VIDGENX_AFFINE_SSE2)
+	const __m128d b0 = _mm_loadu_pd(&b.m00);
+	const __m128d b1 = _mm_loadu_pd(&b.m10);
+	const __m128d b2 = _mm_loadu_pd(&b.m20);
+
+	const __m128d r0 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(a.m00), b0), _mm_mul_pd(_mm_set1_pd(a.m01), b1));
+	const __m128d r1 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(a.m10), b0), _mm_mul_pd(_mm_set1_pd(a.m11), b1));
+	const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(a.m20), b0), _mm_mul_pd(_mm_set1_pd(a.m21), b1)), b2);
+
+	_mm_storeu_pd(&out.m00, r0);
+	_mm_storeu_pd(&out.m10, r1);
+	_mm_storeu_pd(&out.m20, r2);
+#elif defined(VIDGENX_AFFINE_NEON)
+	const float64x2_t b0 = vld1q_f64(&b.m00);
+	const float64x2_t b1 = vld1q_f64(&b.m10);
+	const float64x2_t b2 = vld1q_f64(&b.m20);
+
+	const float64x2_t r0 = vfmaq_n_f64(vmulq_n_f64(b0, a.m00), b1, a.m01);
+	const float64x2_t r1 = vfmaq_n_f64(vmulq_n_f64(b0, a.m10), b1, a.m11);
+	const float64x2_t r2 = vfmaq_n_f64(vfmaq_n_f64(b2, b0, a.m20), b1, a.m21);
+
+	vst1q_f64(&out.m00, r0);
+	vst1q_f64(&out.m10, r1);
+	vst1q_f64(&out.m20, r2);
+#else
+	const double r00 = a.m00 * b.m00 + a.m01 * b.m10;
+	const double r01 = a.m00 * b.m01 + a.m01 * b.m11;
+	const double r10 = a.m10 * b.m00 + a.m11 * b.m10;
+	const double r11 = a.m10 * b.m01 + a.m11 * b.m11;
+	const double r20 = a.m20 * b.m00 + a.m21 * b.m10 + b.m20;
+	const double r21 = a.m20 * b.m01 + a.m21 * b.m11 + b.m21;
+
+	out.m00 = r00; out.m01 = r01;
+	out.m10 = r10; out.m11 = r11;
+	out.m20 = r20; out.m21 = r21;
+#endif
+}
+
+// maps corners of the rectangle (0, 0, width, height) by given matrix; the corners are in the drawing order
+inline void Map_Rectangle(const BLMatrix2D& m, double width, double height, BLPoint (&out)[4]) {
+#if defined(VIDGENX_AFFINE_SSE2)
+	const __m128d origin = _mm_loadu_pd(&m.m20);
+	const __m128d dx = _mm_mul_pd(_mm_loadu_pd(&m.m00), _mm_set1_pd(width));
+	const __m128d dy = _mm_mul_pd(_mm_loadu_pd(&m.m10), _mm_set1_pd(height));
+
+	_mm_storeu_pd(&out[0].x, origin);
+	_mm_storeu_pd(&out[1].x, _mm_add_pd(origin, dx));
+	_mm_storeu_pd(&out[2].x, _mm_add_pd(_mm_add_pd(origin, dx), dy));
+	_mm_storeu_pd(&out[3].x, _mm_add_pd(origin, dy));
+#elif defined(VIDGENX_AFFINE_NEON)
+	const float64x2_t origin = vld1q_f64(&m.m20);
+	const float64x2_t dx = vmulq_n_f64(vld1q_f64(&m.m00), width);
+	const float64x2_t dy = vmulq_n_f64(vld1q_f64(&m.m10), height);
+
+	vst1q_f64(&out[0].x, origin);
+	vst1q_f64(&out[1].x, vaddq_f64(origin, dx));
+	vst1q_f64(&out[2].x, vaddq_f64(vaddq_f64(origin, dx), dy));
+	vst1q_f64(&out[3].x, vaddq_f64(origin, dy));
+#else
+	const double dxx = m.m00 * width, dxy = m.m01 * width;
+	const double dyx = m.m10 * height, dyy = m.m11 * height;
+
+	out[0] = BLPoint(m.m20, m.m21);
+	out[1] = BLPoint(m.m20 + dxx, m.m21 + dxy);
+	out[2] = BLPoint(m.m20 + dxx + dyx, m.m21 + dxy + dyy);
+	out[3] = BLPoint(m.m20 + dyx, m.m21 + dyy);
+#endif
+}
@@ -0,0 +1,51 @@
+#include "bounds.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+BLBox Get_Rectangle_Bounds(const BLMatrix2D& transform, double width, double height, double strokeWidth) {
+
+	// miter joins of a rectangle stick out by less than the full stroke width
+	const double x0 = std::min(0.0, width) - strokeWidth;
+	const double y0 = std::min(0.0, height) - strokeWidth;
+	const double x1 = std::max(0.0, width) + strokeWidth;
+	const double y1 = std::max(0.0, height) + strokeWidth;
+
+	const double corners[4][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } };
+
+	BLBox box = Empty_Box();
+
+	for (auto& c : corners) {
+		const double x = c[0] * transform.m00 + c[1] * transform.m10 + transform.m20;
+		const double y = c[0] * transform.m01 + c[1] * transform.m11 + transform.m21;
+
+		box = Union_Box(box, BLBox(x, y, x, y));
+	}
+
+	return box;
+}
+
+BLBox Get_Circle_Bounds(const BLMatrix2D& transform, double radius, double strokeWidth) {
+
+	const double r = std::abs(radius) + strokeWidth;
+
+	// a transformed circle is an ellipse; these are its exact half-extents along the axes
+	const double ex = r * std::sqrt(transform.m00 * transform.m00 + transform.m10 * transform.m10);
+	const double ey = r * std::sqrt(transform.m01 * transform.m01 + transform.m11 * transform.m11);
+
+	return BLBox(transform.m20 - ex, transform.m21 - ey, transform.m20 + ex, transform.m21 + ey);
+}
+
+bool Is_Empty_Box(const BLBox& box) {
+	return box.x0 > box.x1 || box.y0 > box.y1;
+}
+
+BLBox Empty_Box() {
+	constexpr double inf = std::numeric_limits<double>::infinity();
+	return BLBox(inf, inf, -inf, -inf);
+}
+
+BLBox Union_Box(const BLBox& a, const BLBox& b) {
+	return BLBox(std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1));
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <blend2d.h>
+
+// conservative bounding box of a stroked rectangle (0, 0, width, height) transformed by given matrix
+BLBox Get_Rectangle_Bounds(const BLMatrix2D& transform, double width, double height, double strokeWidth);
+// conservative bounding box of a stroked circle centered at (0, 0) transformed by given matrix
+BLBox Get_Circle_Bounds(const BLMatrix2D& transform, double radius, double strokeWidth);
+
+// is the box empty (e.g., nothing was added to it)?
+bool Is_Empty_Box(const BLBox& box);
+// retrieves an empty box, that serves as a neutral element for Union_Box
+BLBox Empty_Box();
+// retrieves the smallest box containing both given boxes
+BLBox Union_Box(const BLBox& a, const BLBox& b);
@@ -0,0 +1,118 @@
+#include "damage_region.h"
+
+#include <cmath>
+#include <algorithm>
+
+CDamage_Region::CDamage_Region(int width, int height) : mWidth(width), mHeight(height) {
+	//
+}
+
+void CDamage_Region::Add(const BLBox& box) {
+
+	if (mFull) {
+		return;
+	}
+
+	// we cannot tell what changed, so everything did
+	if (std::isnan(box.x0) || std::isnan(box.y0) || std::isnan(box.x1) || std::isnan(box.y1)) {
+		Set_Full();
+		return;
+	}
+
+	if (box.x0 > box.x1 || box.y0 > box.y1) {
+		return;
+	}
+
+	auto clampX = [this](double v) { return std::clamp(v, -1.0, static_cast<double>(mWidth) + 1.0); };
+	auto clampY = [this](double v) { return std::clamp(v, -1.0, static_cast<double>(mHeight) + 1.0); };
+
+	// one extra pixel on every side covers antialiased edges
+	const int x0 = std::max(0, static_cast<int>(std::floor(clampX(box.x0))) - 1);
+	const int y0 = std::max(0, static_cast<int>(std::floor(clampY(box.y0))) - 1);
+	const int x1 = std::min(mWidth, static_cast<int>(std::ceil(clampX(box.x1))) + 1);
+	const int y1 = std::min(mHeight, static_cast<int>(std::ceil(clampY(box.y1))) + 1);
+
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	Add_Box(BLBoxI(x0, y0, x1, y1));
+}
+
+void CDamage_Region::Add(const CDamage_Region& other) {
+
+	if (mFull) {
+		return;
+	}
+
+	if (other.mFull) {
+		Set_Full();
+		return;
+	}
+
+	for (auto& box : other.mBoxes) {
+		Add_Box(box);
+	}
+}
+
+void CDamage_Region::Add_Box(BLBoxI box) {
+
+	// merge with all overlapping boxes, repeat while the merged box grows into another one
+	bool merged = true;
+	while (merged) {
+		merged = false;
+
+		for (auto itr = mBoxes.begin(); itr != mBoxes.end(); ++itr) {
+			if (itr->x0 <= box.x1 && box.x0 <= itr->x1 && itr->y0 <= box.y1 && box.y0 <= itr->y1) {
+				box = BLBoxI(std::min(box.x0, itr->x0), std::min(box.y0, itr->y0), std::max(box.x1, itr->x1), std::max(box.y1, itr->y1));
+				mBoxes.erase(itr);
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	mBoxes.push_back(box);
+
+	if (mBoxes.size() > Max_Boxes) {
+		BLBoxI bounds = mBoxes.front();
+		for (auto& b : mBoxes) {
+			bounds = BLBoxI(std::min(bounds.x0, b.x0), std::min(bounds.y0, b.y0), std::max(bounds.x1, b.x1), std::max(bounds.y1, b.y1));
+		}
+
+		mBoxes.clear();
+		mBoxes.push_back(bounds);
+	}
+
+	// redrawing most of the canvas piece by piece is not worth it
+	size_t area = 0;
+	for (auto& b : mBoxes) {
+		area += static_cast<size_t>(b.x1 - b.x0) * static_cast<size_t>(b.y1 - b.y0);
+	}
+
+	if (area * 2 > static_cast<size_t>(mWidth) * static_cast<size_t>(mHeight)) {
+		Set_Full();
+	}
+}
+
+void CDamage_Region::Set_Full() {
+	mFull = true;
+	mBoxes.clear();
+}
+
+void CDamage_Region::Clear() {
+	mFull = false;
+	mBoxes.clear();
+}
+
+bool CDamage_Region::Is_Full() const {
+	return mFull;
+}
+
+bool CDamage_Region::Is_Empty() const {
+	return !mFull && mBoxes.empty();
+}
+
+const std::vector<BLBoxI>& CDamage_Region::Get_Boxes() const {
+	return mBoxes;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <blend2d.h>
+
+/*
+ * Set of canvas areas, that changed since some earlier frame; kept as a small number of non-overlapping boxes
+ */
+class CDamage_Region {
+	private:
+		// maximum number of boxes kept; more boxes are collapsed to their bounding box
+		static constexpr size_t Max_Boxes = 16;
+
+		// canvas dimensions
+		int mWidth = 0, mHeight = 0;
+		// is the whole canvas damaged?
+		bool mFull = false;
+		// damaged boxes (pixel coordinates, clipped to canvas)
+		std::vector<BLBoxI> mBoxes;
+
+		// adds a pixel-aligned box, merges it with overlapping ones
+		void Add_Box(BLBoxI box);
+
+	public:
+		CDamage_Region() = default;
+		CDamage_Region(int width, int height);
+
+		// adds a box in canvas coordinates; it's expanded to whole pixels (including antialiasing)
+		void Add(const BLBox& box);
+		// adds all damage from another region
+		void Add(const CDamage_Region& other);
+		// marks the whole canvas as damaged
+		void Set_Full();
+		// removes all damage
+		void Clear();
+
+		// is the whole canvas damaged?
+		bool Is_Full() const;
+		// is there no damage at all?
+		bool Is_Empty() const;
+		// retrieves damaged boxes (valid only if the region is not full)
+		const std::vector<BLBoxI>& Get_Boxes() const;
+};
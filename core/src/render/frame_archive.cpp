@@ -0,0 +1,201 @@
+#include "frame_archive.h"
+#include "../input_buffer.h"
+
+#include <cstring>
+#include <bit>
+
+#include <spdlog/spdlog.h>
+
+// the archive structures are written as they are in memory
+static_assert(std::endian::native == std::endian::little, "The frame archive layout requires a little endian machine");
+static_assert(sizeof(TArchive_Header) == 40 && sizeof(TArchive_Entry) == 16 && sizeof(TArchive_Footer) == 24, "Unexpected frame archive structure padding");
+
+namespace {
+	constexpr char Header_Magic[8] = { 'V', 'G', 'X', 'F', 'R', 'A', 'M', 'E' };
+	constexpr char Footer_Magic[8] = { 'V', 'G', 'X', 'I', 'N', 'D', 'E', 'X' };
+	constexpr uint32_t Archive_Version = 1;
+
+	// size of the stream buffer of the writer
+	constexpr size_t Write_Buffer_Size = 4 * 1024 * 1024;
+}
+
+CFrame_Archive_Writer::~CFrame_Archive_Writer() {
+	if (mFile) {
+		std::fclose(mFile);
+	}
+}
+
+bool CFrame_Archive_Writer::Open(const std::filesystem::path& path, const TArchive_Info& info) {
+
+	mFile = std::fopen(path.string().c_str(), "wb");
+	if (!mFile) {
+		spdlog::error("Cannot create frame archive {}", path.string());
+		return false;
+	}
+
+	mBuffer.resize(Write_Buffer_Size);
+	std::setvbuf(mFile, mBuffer.data(), _IOFBF, mBuffer.size());
+
+	mInfo = info;
+
+	TArchive_Header header{};
+	std::memcpy(header.magic, Header_Magic, sizeof(header.magic));
+	header.version = Archive_Version;
+	header.format = static_cast<uint32_t>(info.format);
+	header.width = info.width;
+	header.height = info.height;
+	header.fps = info.fps;
+	header.firstFrame = info.firstFrame;
+
+	if (std::fwrite(&header, sizeof(header), 1, mFile) != 1) {
+		spdlog::error("Cannot write frame archive {}", path.string());
+		return false;
+	}
+
+	mOffset = sizeof(header);
+
+	return true;
+}
+
+bool CFrame_Archive_Writer::Append(uint64_t frame, size_t repeat, const uint8_t* data, size_t size) {
+
+	if (!mFile || frame < mInfo.firstFrame) {
+		return false;
+	}
+
+	if (size > 0 && std::fwrite(data, 1, size, mFile) != size) {
+		return false;
+	}
+
+	const size_t first = static_cast<size_t>(frame - mInfo.firstFrame);
+	if (mIndex.size() < first + repeat + 1) {
+		mIndex.resize(first + repeat + 1, TArchive_Entry{ 0, 0 });
+	}
+
+	for (size_t i = first; i <= first + repeat; i++) {
+		mIndex[i] = { mOffset, size };
+	}
+
+	mOffset += size;
+
+	return true;
+}
+
+bool CFrame_Archive_Writer::Close() {
+
+	if (!mFile) {
+		return false;
+	}
+
+	TArchive_Footer footer{};
+	footer.indexOffset = mOffset;
+	footer.frameCount = mIndex.size();
+	std::memcpy(footer.magic, Footer_Magic, sizeof(footer.magic));
+
+	bool ok = mIndex.empty() || std::fwrite(mIndex.data(), sizeof(TArchive_Entry), mIndex.size(), mFile) == mIndex.size();
+	ok = ok && std::fwrite(&footer, sizeof(footer), 1, mFile) == 1;
+
+	if (std::fclose(mFile) != 0) {
+		ok = false;
+	}
+	mFile = nullptr;
+
+	return ok;
+}
+
+CFrame_Archive_Reader::CFrame_Archive_Reader() {
+	//
+}
+
+CFrame_Archive_Reader::~CFrame_Archive_Reader() {
+	//
+}
+
+bool CFrame_Archive_Reader::Open(const std::filesystem::path& path) {
+
+	// mapped the same way as the scene definition, so frames are paged in only when they are accessed
+	mData = CInput_Buffer::Open(path);
+	if (!mData) {
+		return false;
+	}
+
+	const uint8_t* base = reinterpret_cast<const uint8_t*>(mData->Get_Data());
+	const size_t size = mData->Get_Size();
+
+	TArchive_Header header;
+	TArchive_Footer footer;
+
+	if (size < sizeof(header) + sizeof(footer)) {
+		spdlog::error("The file {} is not a frame archive", path.string());
+		return false;
+	}
+
+	std::memcpy(&header, base, sizeof(header));
+	std::memcpy(&footer, base + size - sizeof(footer), sizeof(footer));
+
+	if (std::memcmp(header.magic, Header_Magic, sizeof(header.magic)) != 0 || std::memcmp(footer.magic, Footer_Magic, sizeof(footer.magic)) != 0) {
+		spdlog::error("The file {} is not a complete frame archive", path.string());
+		return false;
+	}
+
+	if (header.version != Archive_Version) {
+		spdlog::error("Unsupported frame archive version {} in {}", header.version, path.string());
+		return false;
+	}
+
+	// the frames are passed to encoders and ffmpeg by their format, so it must be one of the known ones
+	switch (static_cast<NFrame_Format>(header.format)) {
+		case NFrame_Format::PNG:
+		case NFrame_Format::QOI:
+		case NFrame_Format::PPM:
+		case NFrame_Format::BMP:
+		case NFrame_Format::Raw:
+			break;
+		default:
+			spdlog::error("Unknown frame format {} in frame archive {}", header.format, path.string());
+			return false;
+	}
+
+	if (header.width == 0 || header.height == 0 || header.fps == 0) {
+		spdlog::error("The header of frame archive {} is damaged", path.string());
+		return false;
+	}
+
+	// the index lies between the frame data and the footer, and all its entries must fit in there
+	if (footer.indexOffset < sizeof(header) || footer.indexOffset > size - sizeof(footer)
+		|| footer.frameCount != (size - sizeof(footer) - footer.indexOffset) / sizeof(TArchive_Entry)
+		|| (size - sizeof(footer) - footer.indexOffset) % sizeof(TArchive_Entry) != 0) {
+		spdlog::error("The index of frame archive {} is damaged", path.string());
+		return false;
+	}
+
+	mInfo.format = static_cast<NFrame_Format>(header.format);
+	mInfo.width = header.width;
+	mInfo.height = header.height;
+	mInfo.fps = header.fps;
+	mInfo.firstFrame = header.firstFrame;
+
+	// the index follows frames of arbitrary sizes, so it does not have to be aligned
+	mIndex = reinterpret_cast<const TArchive_Entry*>(base + footer.indexOffset);
+	mFrame_Count = static_cast<size_t>(footer.frameCount);
+
+	return true;
+}
+
+std::string_view CFrame_Archive_Reader::Get_Frame(size_t index) const {
+
+	if (index >= mFrame_Count) {
+		return {};
+	}
+
+	TArchive_Entry entry;
+	std::memcpy(&entry, mIndex + index, sizeof(entry));
+
+	// the frame data lies between the header and the index
+	const size_t dataEnd = static_cast<size_t>(reinterpret_cast<const char*>(mIndex) - mData->Get_Data());
+	if (entry.offset < sizeof(TArchive_Header) || entry.offset > dataEnd || entry.size > dataEnd - entry.offset) {
+		return {};
+	}
+
+	return std::string_view(mData->Get_Data() + entry.offset, static_cast<size_t>(entry.size));
+}
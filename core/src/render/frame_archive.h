@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <filesystem>
+#include <string_view>
+
+#include "frame_encoder.h"
+
+class CInput_Buffer;
+
+/*
+ * Frame archive layout - a single file holding all encoded frames of a render:
+ *
+ *   header | frame data (appended in the order the frames were written) | index | footer
+ *
+ * The index has an entry for every frame from the first one on, so a frame is found without any search; repeated frames
+ * share the data of the frame they repeat. All numbers are stored little endian
+ */
+struct TArchive_Header {
+	char magic[8];					// "VGXFRAME"
+	uint32_t version;				// layout version
+	uint32_t format;				// NFrame_Format of all the frames
+	uint32_t width;					// frame width in pixels
+	uint32_t height;				// frame height in pixels
+	uint32_t fps;					// frame rate of the video
+	uint32_t reserved;				// zero
+	uint64_t firstFrame;			// global index of the first frame
+};
+
+struct TArchive_Entry {
+	uint64_t offset;				// offset of the frame data from the start of the file
+	uint64_t size;					// size of the frame data; 0 if the frame is missing
+};
+
+struct TArchive_Footer {
+	uint64_t indexOffset;			// offset of the index from the start of the file
+	uint64_t frameCount;			// number of index entries
+	char magic[8];					// "VGXINDEX"
+};
+
+/*
+ * Properties of the frames stored in an archive
+ */
+struct TArchive_Info {
+	NFrame_Format format = NFrame_Format::PNG;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t fps = 0;
+	uint64_t firstFrame = 0;
+};
+
+/*
+ * Append-only frame archive writer; frames may be appended in any order, the index is written when the archive is closed
+ */
+class CFrame_Archive_Writer {
+	private:
+		// archive file
+		std::FILE* mFile = nullptr;
+		// stream buffer, so the frames are written in large chunks
+		std::vector<char> mBuffer;
+		// properties of the frames
+		TArchive_Info mInfo;
+		// offset, where the next frame data will be written
+		uint64_t mOffset = 0;
+		// index entries by frame (relative to the first frame)
+		std::vector<TArchive_Entry> mIndex;
+
+	public:
+		CFrame_Archive_Writer() = default;
+		~CFrame_Archive_Writer();
+
+		CFrame_Archive_Writer(const CFrame_Archive_Writer&) = delete;
+		CFrame_Archive_Writer& operator=(const CFrame_Archive_Writer&) = delete;
+
+		// creates the archive (replacing an existing one) and writes its header
+		bool Open(const std::filesystem::path& path, const TArchive_Info& info);
+		// is the archive open for writing?
+		bool Is_Open() const {
+			return mFile != nullptr;
+		}
+		// appends frame data, that stands for given frame and its repetitions
+		bool Append(uint64_t frame, size_t repeat, const uint8_t* data, size_t size);
+		// writes the index and closes the archive
+		bool Close();
+};
+
+/*
+ * Frame archive reader - the archive is memory mapped, so any frame may be accessed directly (e.g., for a preview)
+ */
+class CFrame_Archive_Reader {
+	private:
+		// mapped archive
+		std::unique_ptr<CInput_Buffer> mData;
+		// properties of the frames
+		TArchive_Info mInfo;
+		// index in the mapped archive
+		const TArchive_Entry* mIndex = nullptr;
+		// number of index entries
+		size_t mFrame_Count = 0;
+
+	public:
+		CFrame_Archive_Reader();
+		~CFrame_Archive_Reader();
+
+		// opens and validates given archive
+		bool Open(const std::filesystem::path& path);
+
+		// retrieves the properties of the frames
+		const TArchive_Info& Get_Info() const {
+			return mInfo;
+		}
+
+		// retrieves the number of frames in the archive
+		size_t Get_Frame_Count() const {
+			return mFrame_Count;
+		}
+
+		// retrieves the encoded data of given frame (relative to the first frame); empty if the frame is missing
+		std::string_view Get_Frame(size_t index) const;
+};
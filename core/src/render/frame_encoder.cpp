@@ -0,0 +1,506 @@
+#include "frame_encoder.h"
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <format>
+#include <string>
+
+#ifdef VIDGENX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+	// pixels of a rasterized frame; PRGB32 is stored as 0xAARRGGBB words (BGRA bytes on little endian machines)
+	struct TPixel_Rows {
+		const uint8_t* data = nullptr;
+		intptr_t stride = 0;
+		int width = 0;
+		int height = 0;
+
+		const uint32_t* Row(int y) const {
+			return reinterpret_cast<const uint32_t*>(data + y * stride);
+		}
+	};
+
+	bool Get_Pixels(const BLImage& image, TPixel_Rows& rows) {
+		BLImageData data;
+		if (image.getData(&data) != BL_SUCCESS) {
+			return false;
+		}
+
+		rows.data = static_cast<const uint8_t*>(data.pixelData);
+		rows.stride = data.stride;
+		rows.width = data.size.w;
+		rows.height = data.size.h;
+		return true;
+	}
+
+	void Put_BE32(uint8_t* dst, uint32_t value) {
+		dst[0] = static_cast<uint8_t>(value >> 24);
+		dst[1] = static_cast<uint8_t>(value >> 16);
+		dst[2] = static_cast<uint8_t>(value >> 8);
+		dst[3] = static_cast<uint8_t>(value);
+	}
+
+	void Put_LE32(uint8_t* dst, uint32_t value) {
+		dst[0] = static_cast<uint8_t>(value);
+		dst[1] = static_cast<uint8_t>(value >> 8);
+		dst[2] = static_cast<uint8_t>(value >> 16);
+		dst[3] = static_cast<uint8_t>(value >> 24);
+	}
+
+	void Append(std::vector<uint8_t>& output, const void* data, size_t size) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		output.insert(output.end(), bytes, bytes + size);
+	}
+
+	// converts a row of opaque pixels to packed RGB
+	void Row_To_RGB(const uint32_t* src, int width, uint8_t* dst) {
+		for (int x = 0; x < width; x++) {
+			const uint32_t px = src[x];
+			dst[0] = static_cast<uint8_t>(px >> 16);
+			dst[1] = static_cast<uint8_t>(px >> 8);
+			dst[2] = static_cast<uint8_t>(px);
+			dst += 3;
+		}
+	}
+
+	uint32_t Update_CRC32(uint32_t crc, const uint8_t* data, size_t size) {
+		if (size == 0) {
+			return crc;
+		}
+#ifdef VIDGENX_HAVE_ZLIB
+		return static_cast<uint32_t>(crc32(crc, data, static_cast<uInt>(size)));
+#else
+		static const auto table = [] {
+			std::array<uint32_t, 256> tab{};
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				tab[i] = c;
+			}
+			return tab;
+		}();
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+#endif
+	}
+
+	uint32_t Compute_Adler32(const uint8_t* data, size_t size) {
+#ifdef VIDGENX_HAVE_ZLIB
+		return static_cast<uint32_t>(adler32(adler32(0, nullptr, 0), data, static_cast<uInt>(size)));
+#else
+		// 5552 is the largest block, for which the sums cannot overflow before the modulo
+		uint32_t a = 1, b = 0;
+		while (size > 0) {
+			const size_t block = std::min<size_t>(size, 5552);
+			for (size_t i = 0; i < block; i++) {
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += block;
+			size -= block;
+		}
+		return (b << 16) | a;
+#endif
+	}
+
+	/*
+	 * PNG encoder of Blend2D - used when no explicit compression level is requested
+	 */
+	class CBlend2D_PNG_Encoder : public CFrame_Encoder {
+		private:
+			BLImageCodec mCodec;
+			BLArray<uint8_t> mEncoded;
+
+		public:
+			CBlend2D_PNG_Encoder() {
+				mCodec.findByName("PNG");
+			}
+
+			bool Encode(const BLImage& image, std::vector<uint8_t>& output) override {
+				mEncoded.clear();
+				if (image.writeToData(mEncoded, mCodec) != BL_SUCCESS) {
+					return false;
+				}
+
+				output.assign(mEncoded.data(), mEncoded.data() + mEncoded.size());
+				return true;
+			}
+	};
+
+	/*
+	 * PNG encoder with selectable compression - RGB scanlines without filtering, deflated by zlib or just stored
+	 */
+	class CPNG_Encoder : public CFrame_Encoder {
+		private:
+			int mLevel;
+			// filtered scanlines (the filter byte and RGB pixels of every row)
+			std::vector<uint8_t> mScanlines;
+			// zlib stream of the scanlines
+			std::vector<uint8_t> mCompressed;
+
+			void Write_Chunk(std::vector<uint8_t>& output, const char* type, const uint8_t* data, size_t size) {
+				uint8_t header[8];
+				Put_BE32(header, static_cast<uint32_t>(size));
+				std::memcpy(header + 4, type, 4);
+				Append(output, header, sizeof(header));
+				Append(output, data, size);
+
+				uint8_t crc[4];
+				Put_BE32(crc, Update_CRC32(Update_CRC32(0, header + 4, 4), data, size));
+				Append(output, crc, sizeof(crc));
+			}
+
+			// wraps the scanlines into a zlib stream of stored (uncompressed) deflate blocks
+			void Store() {
+				constexpr size_t maxBlock = 65535;
+
+				const size_t size = mScanlines.size();
+				const size_t blocks = std::max<size_t>((size + maxBlock - 1) / maxBlock, 1);
+
+				mCompressed.resize(2 + blocks * 5 + size + 4);
+				uint8_t* dst = mCompressed.data();
+
+				// deflate, 32k window, no preset dictionary, fastest compression
+				*dst++ = 0x78;
+				*dst++ = 0x01;
+
+				for (size_t offset = 0, b = 0; b < blocks; b++) {
+					const size_t len = std::min(maxBlock, size - offset);
+
+					*dst++ = (b + 1 == blocks) ? 1 : 0;
+					*dst++ = static_cast<uint8_t>(len);
+					*dst++ = static_cast<uint8_t>(len >> 8);
+					*dst++ = static_cast<uint8_t>(~len);
+					*dst++ = static_cast<uint8_t>(~len >> 8);
+
+					std::memcpy(dst, mScanlines.data() + offset, len);
+					dst += len;
+					offset += len;
+				}
+
+				Put_BE32(dst, Compute_Adler32(mScanlines.data(), size));
+			}
+
+			bool Deflate() {
+#ifdef VIDGENX_HAVE_ZLIB
+				uLongf size = compressBound(static_cast<uLong>(mScanlines.size()));
+				mCompressed.resize(size);
+
+				if (compress2(mCompressed.data(), &size, mScanlines.data(), static_cast<uLong>(mScanlines.size()), mLevel) != Z_OK) {
+					return false;
+				}
+
+				mCompressed.resize(size);
+				return true;
+#else
+				return false;
+#endif
+			}
+
+		public:
+			explicit CPNG_Encoder(int level) : mLevel(level) {
+				//
+			}
+
+			bool Encode(const BLImage& image, std::vector<uint8_t>& output) override {
+				TPixel_Rows rows;
+				if (!Get_Pixels(image, rows)) {
+					return false;
+				}
+
+				const size_t rowBytes = 1 + static_cast<size_t>(rows.width) * 3;
+				mScanlines.resize(rowBytes * rows.height);
+
+				for (int y = 0; y < rows.height; y++) {
+					uint8_t* dst = mScanlines.data() + rowBytes * y;
+					dst[0] = 0;
+					Row_To_RGB(rows.Row(y), rows.width, dst + 1);
+				}
+
+				if (mLevel == 0) {
+					Store();
+				}
+				else if (!Deflate()) {
+					return false;
+				}
+
+				static constexpr uint8_t signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+				// width, height, 8 bits per channel, truecolor, deflate, adaptive filtering, no interlace
+				uint8_t ihdr[13] = { 0 };
+				Put_BE32(ihdr, static_cast<uint32_t>(rows.width));
+				Put_BE32(ihdr + 4, static_cast<uint32_t>(rows.height));
+				ihdr[8] = 8;
+				ihdr[9] = 2;
+
+				output.clear();
+				output.reserve(sizeof(signature) + 3 * 12 + sizeof(ihdr) + mCompressed.size());
+
+				Append(output, signature, sizeof(signature));
+				Write_Chunk(output, "IHDR", ihdr, sizeof(ihdr));
+				Write_Chunk(output, "IDAT", mCompressed.data(), mCompressed.size());
+				Write_Chunk(output, "IEND", nullptr, 0);
+
+				return true;
+			}
+	};
+
+	/*
+	 * QOI encoder - see https://qoiformat.org/qoi-specification.pdf; the frames are opaque, so just the RGB channels are stored
+	 */
+	class CQOI_Encoder : public CFrame_Encoder {
+		public:
+			bool Encode(const BLImage& image, std::vector<uint8_t>& output) override {
+				TPixel_Rows rows;
+				if (!Get_Pixels(image, rows)) {
+					return false;
+				}
+
+				constexpr size_t headerSize = 14;
+				constexpr uint8_t padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+				// the worst case is a full RGB chunk for every pixel
+				const size_t pixelCount = static_cast<size_t>(rows.width) * rows.height;
+				output.resize(headerSize + pixelCount * 4 + sizeof(padding));
+
+				uint8_t* dst = output.data();
+				std::memcpy(dst, "qoif", 4);
+				Put_BE32(dst + 4, static_cast<uint32_t>(rows.width));
+				Put_BE32(dst + 8, static_cast<uint32_t>(rows.height));
+				dst[12] = 3;
+				dst[13] = 0;
+				dst += headerSize;
+
+				// the colors are compared as 0xAARRGGBB words with the alpha forced to opaque
+				std::array<uint32_t, 64> index{};
+				uint32_t prev = 0xFF000000;
+				int run = 0;
+
+				for (int y = 0; y < rows.height; y++) {
+					const uint32_t* src = rows.Row(y);
+
+					for (int x = 0; x < rows.width; x++) {
+						const uint32_t px = src[x] | 0xFF000000;
+
+						if (px == prev) {
+							if (++run == 62) {
+								*dst++ = static_cast<uint8_t>(0xC0 | (run - 1));
+								run = 0;
+							}
+							continue;
+						}
+
+						if (run > 0) {
+							*dst++ = static_cast<uint8_t>(0xC0 | (run - 1));
+							run = 0;
+						}
+
+						const uint8_t r = static_cast<uint8_t>(px >> 16);
+						const uint8_t g = static_cast<uint8_t>(px >> 8);
+						const uint8_t b = static_cast<uint8_t>(px);
+						const size_t hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+						if (index[hash] == px) {
+							*dst++ = static_cast<uint8_t>(hash);
+						}
+						else {
+							index[hash] = px;
+
+							const int8_t vr = static_cast<int8_t>(r - static_cast<uint8_t>(prev >> 16));
+							const int8_t vg = static_cast<int8_t>(g - static_cast<uint8_t>(prev >> 8));
+							const int8_t vb = static_cast<int8_t>(b - static_cast<uint8_t>(prev));
+							const int vgr = vr - vg;
+							const int vgb = vb - vg;
+
+							if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+								*dst++ = static_cast<uint8_t>(0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+							}
+							else if (vg >= -32 && vg <= 31 && vgr >= -8 && vgr <= 7 && vgb >= -8 && vgb <= 7) {
+								*dst++ = static_cast<uint8_t>(0x80 | (vg + 32));
+								*dst++ = static_cast<uint8_t>(((vgr + 8) << 4) | (vgb + 8));
+							}
+							else {
+								*dst++ = 0xFE;
+								*dst++ = r;
+								*dst++ = g;
+								*dst++ = b;
+							}
+						}
+
+						prev = px;
+					}
+				}
+
+				if (run > 0) {
+					*dst++ = static_cast<uint8_t>(0xC0 | (run - 1));
+				}
+
+				std::memcpy(dst, padding, sizeof(padding));
+				dst += sizeof(padding);
+
+				output.resize(static_cast<size_t>(dst - output.data()));
+				return true;
+			}
+	};
+
+	/*
+	 * Binary PPM encoder
+	 */
+	class CPPM_Encoder : public CFrame_Encoder {
+		public:
+			bool Encode(const BLImage& image, std::vector<uint8_t>& output) override {
+				TPixel_Rows rows;
+				if (!Get_Pixels(image, rows)) {
+					return false;
+				}
+
+				const std::string header = std::format("P6\n{} {}\n255\n", rows.width, rows.height);
+				const size_t rowBytes = static_cast<size_t>(rows.width) * 3;
+
+				output.resize(header.size() + rowBytes * rows.height);
+				std::memcpy(output.data(), header.data(), header.size());
+
+				for (int y = 0; y < rows.height; y++) {
+					Row_To_RGB(rows.Row(y), rows.width, output.data() + header.size() + rowBytes * y);
+				}
+
+				return true;
+			}
+	};
+
+	/*
+	 * Uncompressed BMP encoder - a top-down 32-bit bitmap has the same memory layout as the frame
+	 */
+	class CBMP_Encoder : public CFrame_Encoder {
+		public:
+			bool Encode(const BLImage& image, std::vector<uint8_t>& output) override {
+				TPixel_Rows rows;
+				if (!Get_Pixels(image, rows)) {
+					return false;
+				}
+
+				constexpr size_t fileHeaderSize = 14;
+				constexpr size_t infoHeaderSize = 40;
+				const size_t rowBytes = static_cast<size_t>(rows.width) * 4;
+				const size_t imageSize = rowBytes * rows.height;
+
+				output.resize(fileHeaderSize + infoHeaderSize + imageSize);
+				uint8_t* dst = output.data();
+				std::memset(dst, 0, fileHeaderSize + infoHeaderSize);
+
+				// BITMAPFILEHEADER
+				dst[0] = 'B';
+				dst[1] = 'M';
+				Put_LE32(dst + 2, static_cast<uint32_t>(output.size()));
+				Put_LE32(dst + 10, static_cast<uint32_t>(fileHeaderSize + infoHeaderSize));
+
+				// BITMAPINFOHEADER; negative height means the rows are stored top-down
+				uint8_t* info = dst + fileHeaderSize;
+				Put_LE32(info, static_cast<uint32_t>(infoHeaderSize));
+				Put_LE32(info + 4, static_cast<uint32_t>(rows.width));
+				Put_LE32(info + 8, static_cast<uint32_t>(-rows.height));
+				info[12] = 1;
+				info[14] = 32;
+				Put_LE32(info + 20, static_cast<uint32_t>(imageSize));
+
+				uint8_t* pixels = dst + fileHeaderSize + infoHeaderSize;
+				for (int y = 0; y < rows.height; y++) {
+					std::memcpy(pixels + rowBytes * y, rows.Row(y), rowBytes);
+				}
+
+				return true;
+			}
+	};
+
+	/*
+	 * Raw pixel dump - BGRA rows without any header
+	 */
+	class CRaw_Encoder : public CFrame_Encoder {
+		public:
+			bool Encode(const BLImage& image, std::vector<uint8_t>& output) override {
+				TPixel_Rows rows;
+				if (!Get_Pixels(image, rows)) {
+					return false;
+				}
+
+				const size_t rowBytes = static_cast<size_t>(rows.width) * 4;
+				output.resize(rowBytes * rows.height);
+
+				for (int y = 0; y < rows.height; y++) {
+					std::memcpy(output.data() + rowBytes * y, rows.Row(y), rowBytes);
+				}
+
+				return true;
+			}
+	};
+}
+
+std::unique_ptr<CFrame_Encoder> CFrame_Encoder::Create(const TEncoder_Settings& settings) {
+
+	switch (settings.format) {
+		case NFrame_Format::PNG:
+			if (settings.compression < 0 || !Is_Compression_Supported(settings.compression)) {
+				return std::make_unique<CBlend2D_PNG_Encoder>();
+			}
+			return std::make_unique<CPNG_Encoder>(settings.compression);
+		case NFrame_Format::QOI:
+			return std::make_unique<CQOI_Encoder>();
+		case NFrame_Format::PPM:
+			return std::make_unique<CPPM_Encoder>();
+		case NFrame_Format::BMP:
+			return std::make_unique<CBMP_Encoder>();
+		case NFrame_Format::Raw:
+			return std::make_unique<CRaw_Encoder>();
+	}
+
+	return nullptr;
+}
+
+const char* CFrame_Encoder::Get_Extension(NFrame_Format format) {
+
+	switch (format) {
+		case NFrame_Format::PNG: return "png";
+		case NFrame_Format::QOI: return "qoi";
+		case NFrame_Format::PPM: return "ppm";
+		case NFrame_Format::BMP: return "bmp";
+		case NFrame_Format::Raw: return "bgra";
+	}
+
+	return "";
+}
+
+std::optional<NFrame_Format> CFrame_Encoder::Parse_Format(std::string_view name) {
+
+	for (auto format : { NFrame_Format::PNG, NFrame_Format::QOI, NFrame_Format::PPM, NFrame_Format::BMP, NFrame_Format::Raw }) {
+		if (name == Get_Extension(format)) {
+			return format;
+		}
+	}
+
+	if (name == "raw") {
+		return NFrame_Format::Raw;
+	}
+
+	return std::nullopt;
+}
+
+bool CFrame_Encoder::Is_Compression_Supported(int level) {
+#ifdef VIDGENX_HAVE_ZLIB
+	return level >= 0 && level <= 9;
+#else
+	// stored blocks do not need zlib
+	return level == 0;
+#endif
+}
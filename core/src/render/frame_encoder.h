@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+#include <blend2d.h>
+
+/*
+ * Image file format of written frames
+ */
+enum class NFrame_Format {
+	PNG,		// compressed, lossless; the slowest to encode, the smallest on disk
+	QOI,		// "Quite OK Image" format; lossless, several times faster than PNG at a slightly worse ratio
+	PPM,		// uncompressed RGB (binary portable pixmap)
+	BMP,		// uncompressed 32-bit bitmap; the rows are copied as they are
+	Raw,		// bare pixels in the memory layout of the renderer (BGRA), no header
+};
+
+/*
+ * Frame encoder settings
+ */
+struct TEncoder_Settings {
+	NFrame_Format format = NFrame_Format::PNG;		// output format
+	int compression = -1;							// PNG compression level: 0 (stored) to 9; -1 keeps the Blend2D encoder default
+};
+
+/*
+ * Frame encoder - converts a rasterized frame to the bytes of an image file
+ *
+ * An encoder keeps its scratch buffers between frames, so every thread encoding frames needs its own instance
+ */
+class CFrame_Encoder {
+	public:
+		virtual ~CFrame_Encoder() = default;
+
+		// encodes the image into the output (replacing its content)
+		virtual bool Encode(const BLImage& image, std::vector<uint8_t>& output) = 0;
+
+		// creates an encoder for given settings
+		static std::unique_ptr<CFrame_Encoder> Create(const TEncoder_Settings& settings);
+		// retrieves the file extension of given format (without the dot)
+		static const char* Get_Extension(NFrame_Format format);
+		// parses format name (as in the command line or configuration)
+		static std::optional<NFrame_Format> Parse_Format(std::string_view name);
+		// can the PNG encoder use given compression level in this build?
+		static bool Is_Compression_Supported(int level);
+};
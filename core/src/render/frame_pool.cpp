@@ -0,0 +1,75 @@
+#include "frame_pool.h"
+
+#include <algorithm>
+
+CFrame_Buffer::CFrame_Buffer(int width, int height) : mImage(width, height, BL_FORMAT_PRGB32), mContext(mImage) {
+	//
+}
+
+CFrame_Buffer::~CFrame_Buffer() {
+	mContext.end();
+}
+
+const BLImage& CFrame_Buffer::Get_Image() const {
+	return mImage;
+}
+
+BLContext& CFrame_Buffer::Get_Context() {
+	return mContext;
+}
+
+void CFrame_Buffer::Sync() {
+	mContext.flush(BL_CONTEXT_FLUSH_SYNC);
+}
+
+CFrame_Pool::CFrame_Pool(int width, int height, size_t count) {
+
+	mBuffer_Size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+
+	for (size_t i = 0; i < count; i++) {
+		mBuffers.push_back(std::make_unique<CFrame_Buffer>(width, height));
+		mBorrowed.push_back(false);
+		mTurn.push_back(0);
+		mAllocations++;
+	}
+}
+
+CFrame_Buffer* CFrame_Pool::Acquire(size_t index, size_t turn) {
+	std::unique_lock lck(mMutex);
+
+	mBuffer_Returned.wait(lck, [this, index, turn] { return !mBorrowed[index] && mTurn[index] == turn; });
+
+	mBorrowed[index] = true;
+	mTurn[index]++;
+	mBorrows++;
+
+	return mBuffers[index].get();
+}
+
+void CFrame_Pool::Release(CFrame_Buffer* buffer) {
+	std::unique_lock lck(mMutex);
+
+	auto itr = std::find_if(mBuffers.begin(), mBuffers.end(), [buffer](auto& buf) { return buf.get() == buffer; });
+	if (itr == mBuffers.end()) {
+		return;
+	}
+
+	mBorrowed[std::distance(mBuffers.begin(), itr)] = false;
+	mBuffer_Returned.notify_all();
+}
+
+size_t CFrame_Pool::Get_Buffer_Count() const {
+	return mBuffers.size();
+}
+
+size_t CFrame_Pool::Get_Memory_Size() const {
+	return mBuffers.size() * mBuffer_Size;
+}
+
+size_t CFrame_Pool::Get_Allocation_Count() const {
+	return mAllocations;
+}
+
+size_t CFrame_Pool::Get_Borrow_Count() const {
+	return mBorrows;
+}
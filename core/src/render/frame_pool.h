@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include <blend2d.h>
+
+/*
+ * Reusable frame buffer - an image with a rendering context permanently attached to it
+ */
+class CFrame_Buffer {
+	private:
+		// frame image
+		BLImage mImage;
+		// rendering context attached to the image
+		BLContext mContext;
+
+	public:
+		CFrame_Buffer(int width, int height);
+		virtual ~CFrame_Buffer();
+
+		// retrieves the frame image; the context must be synchronized (see Sync) before reading pixels
+		const BLImage& Get_Image() const;
+		// retrieves the attached rendering context
+		BLContext& Get_Context();
+
+		// waits for all pending rendering commands, so the image may be read
+		void Sync();
+};
+
+/*
+ * Pool of preallocated frame buffers - frames borrow a buffer for rasterization and return it once it's encoded or written;
+ * the pool never grows, so there are no buffer allocations once the rendering starts
+ *
+ * The caller assigns buffers to frames (the pipeline does so in round-robin fashion within every channel), so every buffer keeps
+ * the frame rendered to it last time; this is what allows incremental rendering. Every use of a buffer has its turn, so the
+ * frames are drawn to a buffer in the order they were assigned to it, no matter which thread comes first
+ */
+class CFrame_Pool {
+	private:
+		// guards the borrowed flags
+		std::mutex mMutex;
+		// signalled when a buffer is returned
+		std::condition_variable mBuffer_Returned;
+
+		// all buffers owned by the pool
+		std::vector<std::unique_ptr<CFrame_Buffer>> mBuffers;
+		// is the buffer (with the same index) borrowed right now?
+		std::vector<bool> mBorrowed;
+		// turn of the next borrower of the buffer (with the same index)
+		std::vector<size_t> mTurn;
+
+		// size of a single buffer in bytes
+		size_t mBuffer_Size = 0;
+		// number of buffer allocations performed by the pool
+		size_t mAllocations = 0;
+		// number of times a buffer was borrowed
+		size_t mBorrows = 0;
+
+	public:
+		CFrame_Pool(int width, int height, size_t count);
+
+		// borrows the buffer with given index at given turn (0 for the first use of the buffer, 1 for the second, ...); blocks
+		// until all the previous turns borrowed and returned the buffer
+		CFrame_Buffer* Acquire(size_t index, size_t turn);
+		// returns a borrowed buffer to the pool
+		void Release(CFrame_Buffer* buffer);
+
+		// retrieves the number of buffers in the pool
+		size_t Get_Buffer_Count() const;
+		// retrieves total memory held by the pool buffers in bytes
+		size_t Get_Memory_Size() const;
+		// retrieves the number of buffer allocations
+		size_t Get_Allocation_Count() const;
+		// retrieves the number of times a buffer was borrowed
+		size_t Get_Borrow_Count() const;
+};
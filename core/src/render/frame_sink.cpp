@@ -0,0 +1,622 @@
+#include "frame_sink.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef VIDGENX_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "../profiler.h"
+
+namespace {
+	// alignment of direct I/O buffers, offsets and lengths; the logical block size of common devices does not exceed it
+	constexpr size_t Direct_IO_Alignment = 4096;
+
+	// switches a file opened for direct I/O to buffered writes; a short direct write leaves an unaligned offset and length,
+	// that direct I/O would reject
+	bool Drop_Direct_IO(int fd) {
+#if !defined(_WIN32) && defined(O_DIRECT)
+		const int flags = fcntl(fd, F_GETFL);
+		return flags >= 0 && fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0;
+#else
+		return true;
+#endif
+	}
+
+	// writes the whole buffer, retrying after partial writes; the tail of a short direct write is written buffered
+	bool Write_All(int fd, const uint8_t* data, size_t length, bool direct = false) {
+		while (length > 0) {
+#ifdef _WIN32
+			const int written = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(length, 1 << 30)));
+#else
+			const ssize_t written = write(fd, data, length);
+#endif
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+
+			data += written;
+			length -= static_cast<size_t>(written);
+
+			if (direct && length > 0) {
+				if (!Drop_Direct_IO(fd)) {
+					return false;
+				}
+				direct = false;
+			}
+		}
+
+		return true;
+	}
+
+	int Close_File(int fd) {
+#ifdef _WIN32
+		return _close(fd);
+#else
+		return close(fd);
+#endif
+	}
+
+	// cuts the padding of a direct write off the end of the file
+	bool Truncate_File(int fd, size_t size) {
+#ifdef _WIN32
+		return _chsize_s(fd, static_cast<long long>(size)) == 0;
+#else
+		return ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+	}
+
+	/*
+	 * Sink writing the files one by one from its thread - every file is written with a single large write
+	 */
+	class CThread_Frame_Sink : public CFrame_Sink {
+		protected:
+			void Write_Batch(std::vector<TSink_File>& batch) override {
+				for (auto& file : batch) {
+					bool direct = mSettings.directIO;
+					const int fd = Open_File(file.path, direct);
+					if (fd < 0) {
+						spdlog::error("Cannot open frame file {}: {}", file.path.string(), std::strerror(errno));
+						Complete(file, false);
+						continue;
+					}
+
+					bool ok;
+					if (direct) {
+						size_t length = 0;
+						auto buffer = Make_Direct_Buffer(file.data, length);
+						ok = buffer && Write_All(fd, buffer.get(), length, true) && Truncate_File(fd, file.data.size());
+					}
+					else {
+						ok = Write_All(fd, file.data.data(), file.data.size());
+					}
+
+					// the error of the failed call, before anything else overwrites it
+					int error = ok ? 0 : errno;
+
+					if (Close_File(fd) != 0 && ok) {
+						ok = false;
+						error = errno;
+					}
+
+					if (!ok) {
+						spdlog::error("Cannot write frame file {}: {}", file.path.string(), std::strerror(error));
+					}
+
+					Complete(file, ok);
+				}
+			}
+
+		public:
+			explicit CThread_Frame_Sink(const TSink_Settings& settings) : CFrame_Sink(settings) {
+				//
+			}
+
+			~CThread_Frame_Sink() override {
+				Finish();
+			}
+
+			const char* Get_Name() const override {
+				return "writer thread";
+			}
+	};
+
+#ifdef VIDGENX_HAVE_LIBURING
+	/*
+	 * Sink keeping up to the queue depth of writes in flight through io_uring, so the latency of a slow (e.g., network)
+	 * storage is paid once per batch instead of once per file
+	 */
+	class CUring_Frame_Sink : public CFrame_Sink {
+		private:
+			// a single file being written
+			struct TWrite_Request {
+				TSink_File* file = nullptr;
+				int fd = -1;
+				bool direct = false;
+				std::unique_ptr<uint8_t, void(*)(void*)> directBuffer{ nullptr, std::free };
+				const uint8_t* data = nullptr;		// data to be written
+				size_t length = 0;					// length of the data (padded for direct I/O)
+				size_t offset = 0;					// bytes written so far
+			};
+
+			struct io_uring mRing;
+			bool mInitialized = false;
+
+			// queues the next write of the request; returns false, if the submission queue has no room even after submitting
+			bool Submit(TWrite_Request& req) {
+				struct io_uring_sqe* sqe = io_uring_get_sqe(&mRing);
+				if (!sqe) {
+					// the queue is full of writes not passed to the kernel yet
+					io_uring_submit(&mRing);
+					sqe = io_uring_get_sqe(&mRing);
+					if (!sqe) {
+						return false;
+					}
+				}
+
+				io_uring_prep_write(sqe, req.fd, req.data + req.offset, static_cast<unsigned>(std::min<size_t>(req.length - req.offset, 1u << 30)), req.offset);
+				io_uring_sqe_set_data(sqe, &req);
+				return true;
+			}
+
+			// completes the request; error is the errno value of a failed write
+			void Finish_Request(TWrite_Request& req, bool ok, int error = 0) {
+				if (ok && req.direct && !Truncate_File(req.fd, req.file->data.size())) {
+					ok = false;
+					error = errno;
+				}
+				if (Close_File(req.fd) != 0 && ok) {
+					ok = false;
+					error = errno;
+				}
+				req.fd = -1;
+
+				if (!ok) {
+					spdlog::error("Cannot write frame file {}: {}", req.file->path.string(), std::strerror(error));
+				}
+
+				Complete(*req.file, ok);
+			}
+
+		protected:
+			void Write_Batch(std::vector<TSink_File>& batch) override {
+				std::vector<TWrite_Request> requests(batch.size());
+
+				size_t next = 0;
+				size_t inFlight = 0;
+
+				while (next < batch.size() || inFlight > 0) {
+
+					// fill the queue up to its depth
+					while (next < batch.size() && inFlight < mSettings.queueDepth) {
+						auto& req = requests[next];
+						req.file = &batch[next++];
+						req.direct = mSettings.directIO;
+						req.fd = Open_File(req.file->path, req.direct);
+
+						if (req.fd < 0) {
+							spdlog::error("Cannot open frame file {}: {}", req.file->path.string(), std::strerror(errno));
+							Complete(*req.file, false);
+							continue;
+						}
+
+						if (req.direct) {
+							req.directBuffer = Make_Direct_Buffer(req.file->data, req.length);
+							req.data = req.directBuffer.get();
+							if (!req.data) {
+								Finish_Request(req, false, errno);
+								continue;
+							}
+						}
+						else {
+							req.data = req.file->data.data();
+							req.length = req.file->data.size();
+						}
+
+						if (req.length == 0) {
+							Finish_Request(req, true);
+							continue;
+						}
+
+						if (!Submit(req)) {
+							Finish_Request(req, false, EBUSY);
+							continue;
+						}
+						inFlight++;
+					}
+
+					if (inFlight == 0) {
+						continue;
+					}
+
+					io_uring_submit(&mRing);
+
+					// the wait is interrupted by signals, the requests stay in flight
+					struct io_uring_cqe* cqe = nullptr;
+					const int waited = io_uring_wait_cqe(&mRing, &cqe);
+					if (waited == -EINTR) {
+						continue;
+					}
+
+					// the ring is not usable anymore, so neither the requests in flight, nor the rest of the batch get written
+					if (waited < 0) {
+						spdlog::error("Cannot wait for frame writes: {}", std::strerror(-waited));
+
+						for (size_t i = 0; i < next; i++) {
+							if (requests[i].fd >= 0) {
+								Finish_Request(requests[i], false, -waited);
+							}
+						}
+						while (next < batch.size()) {
+							Complete(batch[next++], false);
+						}
+						return;
+					}
+
+					// reap everything, that is completed
+					do {
+						auto& req = *static_cast<TWrite_Request*>(io_uring_cqe_get_data(cqe));
+						const int res = cqe->res;
+						io_uring_cqe_seen(&mRing, cqe);
+
+						int error = (res < 0) ? -res : EIO;
+
+						if (res == -EINTR || res == -EAGAIN) {
+							if (Submit(req)) {
+								continue;
+							}
+							error = EBUSY;
+						}
+						else if (res > 0) {
+							req.offset += static_cast<size_t>(res);
+
+							// a partial write continues where it stopped; a direct one in buffered mode, as the rest is not aligned
+							if (req.offset < req.length) {
+								if (req.direct && !Drop_Direct_IO(req.fd)) {
+									error = errno;
+								}
+								else if (Submit(req)) {
+									continue;
+								}
+								else {
+									error = EBUSY;
+								}
+							}
+						}
+
+						// a write of nothing at all would never complete the file
+						Finish_Request(req, res > 0 && req.offset >= req.length, error);
+						inFlight--;
+					} while (io_uring_peek_cqe(&mRing, &cqe) == 0);
+				}
+			}
+
+		public:
+			explicit CUring_Frame_Sink(const TSink_Settings& settings) : CFrame_Sink(settings) {
+				mSettings.queueDepth = std::max(mSettings.queueDepth, static_cast<size_t>(1));
+				mInitialized = (io_uring_queue_init(static_cast<unsigned>(mSettings.queueDepth), &mRing, 0) == 0);
+			}
+
+			~CUring_Frame_Sink() override {
+				Finish();
+
+				if (mInitialized) {
+					io_uring_queue_exit(&mRing);
+				}
+			}
+
+			bool Is_Initialized() const {
+				return mInitialized;
+			}
+
+			const char* Get_Name() const override {
+				return "io_uring";
+			}
+	};
+#endif
+
+	/*
+	 * Sink appending all the frames to a single archive - the pipeline hands the archived frames over in frame order, so the
+	 * archive is written (and later read) sequentially, and the storage sees a single growing file instead of thousands of
+	 * small ones
+	 */
+	class CArchive_Frame_Sink : public CFrame_Sink {
+		private:
+			CFrame_Archive_Writer mArchive;
+
+		protected:
+			void Write_Batch(std::vector<TSink_File>& batch) override {
+				for (auto& file : batch) {
+					const bool ok = mArchive.Append(file.frame, file.repeat, file.data.data(), file.data.size());
+					if (!ok) {
+						spdlog::error("Cannot append frame {} to archive {}: {}", file.frame, mSettings.archive.string(), std::strerror(errno));
+					}
+
+					Complete(file, ok);
+				}
+			}
+
+			bool Finalize() override {
+				// the archive may not have been created at all, which was reported already
+				if (!mArchive.Is_Open()) {
+					return true;
+				}
+
+				if (!mArchive.Close()) {
+					spdlog::error("Cannot write the index of archive {}", mSettings.archive.string());
+					return false;
+				}
+				return true;
+			}
+
+		public:
+			explicit CArchive_Frame_Sink(const TSink_Settings& settings) : CFrame_Sink(settings) {
+				//
+			}
+
+			~CArchive_Frame_Sink() override {
+				Finish();
+			}
+
+			bool Open() {
+				return mArchive.Open(mSettings.archive, mSettings.archiveInfo);
+			}
+
+			const char* Get_Name() const override {
+				return "frame archive";
+			}
+	};
+}
+
+CFrame_Sink::CFrame_Sink(const TSink_Settings& settings) : mSettings(settings) {
+	//
+}
+
+CFrame_Sink::~CFrame_Sink() {
+	Finish();
+}
+
+std::unique_ptr<CFrame_Sink> CFrame_Sink::Create(const TSink_Settings& settings) {
+
+	std::unique_ptr<CFrame_Sink> sink;
+
+	if (!settings.archive.empty()) {
+		auto archive = std::make_unique<CArchive_Frame_Sink>(settings);
+		if (!archive->Open()) {
+			return nullptr;
+		}
+		sink = std::move(archive);
+	}
+
+#ifdef VIDGENX_HAVE_LIBURING
+	if (!sink && settings.backend != NSink_Backend::Thread) {
+		auto uring = std::make_unique<CUring_Frame_Sink>(settings);
+
+		// the kernel may be too old, or io_uring may be disabled
+		if (uring->Is_Initialized()) {
+			sink = std::move(uring);
+		}
+		else {
+			spdlog::warn("Cannot initialize io_uring, frame files are written by a writer thread");
+		}
+	}
+#else
+	if (settings.archive.empty() && settings.backend == NSink_Backend::Uring) {
+		spdlog::warn("This build does not support io_uring, frame files are written by a writer thread");
+	}
+#endif
+
+	if (!sink) {
+		sink = std::make_unique<CThread_Frame_Sink>(settings);
+	}
+
+	sink->mWriter = std::thread(&CFrame_Sink::Writer_Loop, sink.get());
+
+	return sink;
+}
+
+std::optional<NSink_Backend> CFrame_Sink::Parse_Backend(std::string_view name) {
+
+	if (name == "auto") {
+		return NSink_Backend::Auto;
+	}
+	if (name == "thread") {
+		return NSink_Backend::Thread;
+	}
+	if (name == "uring" || name == "io_uring") {
+		return NSink_Backend::Uring;
+	}
+
+	return std::nullopt;
+}
+
+bool CFrame_Sink::Write(TSink_File&& file) {
+
+	const size_t size = file.data.size();
+
+	std::unique_lock lck(mMutex);
+
+	// a file larger than the whole budget is still accepted, once the sink is empty
+	if (mPending_Bytes > 0 && mPending_Bytes + size > mSettings.memoryBudget && !mFailed) {
+		const auto start = std::chrono::steady_clock::now();
+		mWritten.wait(lck, [this, size] { return mPending_Bytes == 0 || mPending_Bytes + size <= mSettings.memoryBudget || mFailed; });
+		mStatistics.blockedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if (mFailed) {
+		return false;
+	}
+
+	mPending_Bytes += size;
+	mStatistics.peakPendingBytes = std::max(mStatistics.peakPendingBytes, mPending_Bytes);
+
+	mQueue.push_back(std::move(file));
+	mQueued.notify_one();
+
+	return true;
+}
+
+bool CFrame_Sink::Finish() {
+	{
+		std::unique_lock lck(mMutex);
+		mFinishing = true;
+		mQueued.notify_all();
+	}
+
+	if (mWriter.joinable()) {
+		mWriter.join();
+	}
+
+	// nothing is written anymore, so the derived sink may complete its output
+	if (!mFinalized) {
+		mFinalized = true;
+		if (!Finalize()) {
+			std::unique_lock lck(mMutex);
+			mFailed = true;
+		}
+	}
+
+	std::unique_lock lck(mMutex);
+	return !mFailed;
+}
+
+TSink_Statistics CFrame_Sink::Get_Statistics() {
+	std::unique_lock lck(mMutex);
+	return mStatistics;
+}
+
+void CFrame_Sink::Writer_Loop() {
+
+	sProfiler.Set_Thread_Name("Frame writer");
+
+	while (true) {
+		std::vector<TSink_File> batch;
+
+		{
+			std::unique_lock lck(mMutex);
+			mQueued.wait(lck, [this] { return !mQueue.empty() || mFinishing; });
+
+			if (mQueue.empty()) {
+				return;
+			}
+
+			batch.reserve(mQueue.size());
+			std::move(mQueue.begin(), mQueue.end(), std::back_inserter(batch));
+			mQueue.clear();
+		}
+
+		CProfile_Scope scope("write", "Write batch");
+
+		const auto start = std::chrono::steady_clock::now();
+		Write_Batch(batch);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::unique_lock lck(mMutex);
+		mStatistics.busySeconds += seconds;
+	}
+}
+
+void CFrame_Sink::Complete(TSink_File& file, bool ok) {
+
+	// identical frames are just hard links to the written one
+	for (auto& link : file.links) {
+		if (!ok) {
+			break;
+		}
+
+		std::error_code ec;
+		std::filesystem::remove(link, ec);
+		std::filesystem::create_hard_link(file.path, link, ec);
+
+		// some file systems do not support hard links, make a copy there
+		if (ec && !std::filesystem::copy_file(file.path, link, std::filesystem::copy_options::overwrite_existing, ec)) {
+			spdlog::error("Cannot write frame file {}: {}", link.string(), ec.message());
+			ok = false;
+		}
+	}
+
+	const size_t size = file.data.size();
+
+	// the data is not needed anymore, release the memory before the budget is
+	file.data = std::vector<uint8_t>();
+
+	std::unique_lock lck(mMutex);
+
+	if (ok) {
+		mStatistics.files += 1 + file.links.size();
+		mStatistics.bytes += size;
+	}
+	else {
+		mFailed = true;
+	}
+
+	mPending_Bytes -= size;
+	mWritten.notify_all();
+}
+
+int CFrame_Sink::Open_File(const std::filesystem::path& path, bool& direct) {
+
+	// the file may be a hard link left over from a previous run; writing through it would overwrite the other frames
+	std::error_code ec;
+	std::filesystem::remove(path, ec);
+
+#ifdef _WIN32
+	direct = false;
+	return _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+#ifdef O_DIRECT
+	if (direct) {
+		const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+		if (fd >= 0 || errno != EINVAL) {
+			return fd;
+		}
+
+		// some file systems (e.g., tmpfs) do not support direct I/O at all
+		spdlog::warn("Direct I/O is not supported for {}, using buffered writes", path.string());
+		mSettings.directIO = false;
+	}
+#endif
+
+	direct = false;
+	return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+}
+
+std::unique_ptr<uint8_t, void(*)(void*)> CFrame_Sink::Make_Direct_Buffer(const std::vector<uint8_t>& data, size_t& length) {
+
+	length = ((data.size() + Direct_IO_Alignment - 1) / Direct_IO_Alignment) * Direct_IO_Alignment;
+
+#ifdef _WIN32
+	std::unique_ptr<uint8_t, void(*)(void*)> buffer(static_cast<uint8_t*>(_aligned_malloc(std::max(length, Direct_IO_Alignment), Direct_IO_Alignment)), _aligned_free);
+#else
+	std::unique_ptr<uint8_t, void(*)(void*)> buffer(static_cast<uint8_t*>(std::aligned_alloc(Direct_IO_Alignment, std::max(length, Direct_IO_Alignment))), std::free);
+#endif
+	if (!buffer) {
+		// the allocation functions are not required to set errno, the callers report it
+		errno = ENOMEM;
+		return buffer;
+	}
+
+	std::memcpy(buffer.get(), data.data(), data.size());
+	std::memset(buffer.get() + data.size(), 0, length - data.size());
+
+	return buffer;
+}
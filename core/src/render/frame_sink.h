@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include "frame_archive.h"
+
+/*
+ * Backend writing the files of a frame sink
+ */
+enum class NSink_Backend {
+	Auto,		// io_uring if available, the writer thread otherwise
+	Thread,		// a dedicated thread writing one file at a time with a single large write
+	Uring,		// a dedicated thread keeping several writes in flight through io_uring (Linux only)
+};
+
+/*
+ * Frame sink settings
+ */
+struct TSink_Settings {
+	NSink_Backend backend = NSink_Backend::Auto;		// preferred backend
+	size_t memoryBudget = 256 * 1024 * 1024;			// maximum of bytes queued or being written; producers block beyond it
+	bool directIO = false;								// bypass the page cache (O_DIRECT) where supported
+	size_t queueDepth = 16;								// maximum of writes in flight at once (io_uring only)
+	std::filesystem::path archive;						// if set, all the frames are appended to this single archive instead of separate files
+	TArchive_Info archiveInfo;							// properties of the archived frames
+};
+
+/*
+ * Frame sink throughput statistics
+ */
+struct TSink_Statistics {
+	size_t files = 0;					// number of files written
+	size_t bytes = 0;					// number of bytes written
+	double busySeconds = 0;				// time the backend spent writing
+	double blockedSeconds = 0;			// time producers waited for the memory budget
+	size_t peakPendingBytes = 0;		// maximum of bytes queued or being written at once
+};
+
+/*
+ * A file handed over to the sink
+ */
+struct TSink_File {
+	std::filesystem::path path;						// file to be (re)written
+	std::vector<uint8_t> data;						// content of the file
+	std::vector<std::filesystem::path> links;		// other names of the same content (hard links, or copies if not supported)
+	size_t frame = 0;								// index of the frame stored in the file
+	size_t repeat = 0;								// number of identical frames following it
+};
+
+/*
+ * Frame sink - writes files asynchronously, so the producers (encoders) do not wait for the storage; the files are
+ * queued up to a memory budget, and only then the producers block
+ *
+ * The writer thread takes all the queued files at once and passes them to the backend as a single batch
+ */
+class CFrame_Sink {
+	private:
+		// guards the state below
+		std::mutex mMutex;
+		// signalled when a file is queued or the sink is finishing
+		std::condition_variable mQueued;
+		// signalled when a file is written
+		std::condition_variable mWritten;
+
+		// files waiting for the writer
+		std::deque<TSink_File> mQueue;
+		// bytes of the files queued or being written
+		size_t mPending_Bytes = 0;
+		// is the sink shutting down?
+		bool mFinishing = false;
+		// was the output finalized already?
+		bool mFinalized = false;
+		// did any write fail?
+		bool mFailed = false;
+		// collected statistics
+		TSink_Statistics mStatistics;
+
+		// writer thread
+		std::thread mWriter;
+
+		// writer thread body
+		void Writer_Loop();
+
+	protected:
+		// sink settings
+		TSink_Settings mSettings;
+
+		explicit CFrame_Sink(const TSink_Settings& settings);
+
+		// writes all the files of a batch; every file must be passed to Complete once it's written (or failed)
+		virtual void Write_Batch(std::vector<TSink_File>& batch) = 0;
+		// completes the output once all the files are written (called once, from the finishing thread)
+		virtual bool Finalize() {
+			return true;
+		}
+		// creates the links of a written file, accounts it and releases its budget
+		void Complete(TSink_File& file, bool ok);
+
+		// opens a file for writing (removing the previous one, that may be a hard link), with O_DIRECT if requested and possible
+		int Open_File(const std::filesystem::path& path, bool& direct);
+		// copies the data to a buffer suitable for direct I/O; the length is rounded up to the block size
+		static std::unique_ptr<uint8_t, void(*)(void*)> Make_Direct_Buffer(const std::vector<uint8_t>& data, size_t& length);
+
+	public:
+		virtual ~CFrame_Sink();
+
+		CFrame_Sink(const CFrame_Sink&) = delete;
+		CFrame_Sink& operator=(const CFrame_Sink&) = delete;
+
+		// creates a sink with the preferred backend, falling back to the writer thread; nullptr if the archive cannot be created
+		static std::unique_ptr<CFrame_Sink> Create(const TSink_Settings& settings);
+		// parses backend name (as in the configuration)
+		static std::optional<NSink_Backend> Parse_Backend(std::string_view name);
+
+		// retrieves the name of the backend
+		virtual const char* Get_Name() const = 0;
+
+		// queues a file for writing; blocks while the memory budget is used up; returns false if a write failed before
+		bool Write(TSink_File&& file);
+		// waits for all queued files to be written and stops the writer; returns false if any write failed
+		bool Finish();
+
+		// retrieves the statistics collected so far
+		TSink_Statistics Get_Statistics();
+};
@@ -0,0 +1,193 @@
+#include "frame_snapshot.h"
+#include "static_layer.h"
+#include "bounds.h"
+#include "primitive_batch.h"
+#include "../profiler.h"
+
+namespace {
+	// profiler categories of primitive rasterization (indexed by NObject_Type)
+	constexpr const char* Raster_Categories[Object_Type_Count] = { "raster.none", "raster.rectangle", "raster.circle", "raster.composite" };
+}
+
+CFrame_Snapshot::CFrame_Snapshot(size_t frameIndex) : mFrame_Index(frameIndex) {
+	mDamage.Set_Full();
+}
+
+void CFrame_Snapshot::Add_Primitive(const TDraw_Primitive& primitive) {
+	if (mPrimitives.size() == mPrimitives.capacity()) {
+		mAllocations++;
+	}
+
+	mPrimitives.push_back(primitive);
+	mPrimitives.back().bounds = Get_Bounds(primitive);
+	mPrimitives.back().owner = mOwner;
+}
+
+void CFrame_Snapshot::Set_Owner(size_t owner) {
+	mOwner = owner;
+}
+
+void CFrame_Snapshot::Set_Owner_Names(const std::shared_ptr<const std::vector<const char*>>& names) {
+	mOwner_Names = names;
+}
+
+size_t CFrame_Snapshot::Get_Frame_Index() const {
+	return mFrame_Index;
+}
+
+void CFrame_Snapshot::Add_Repeat() {
+	mRepeat_Count++;
+}
+
+size_t CFrame_Snapshot::Get_Repeat_Count() const {
+	return mRepeat_Count;
+}
+
+size_t CFrame_Snapshot::Get_Allocation_Count() const {
+	return mAllocations;
+}
+
+std::vector<TDraw_Primitive> CFrame_Snapshot::Take_Primitives() {
+	return std::move(mPrimitives);
+}
+
+void CFrame_Snapshot::Set_Static_Layer(const std::shared_ptr<const CStatic_Layer>& layer) {
+	mStatic_Layer = layer;
+}
+
+void CFrame_Snapshot::Set_Damage(const CDamage_Region& damage) {
+	mDamage = damage;
+}
+
+const CDamage_Region& CFrame_Snapshot::Get_Damage() const {
+	return mDamage;
+}
+
+void CFrame_Snapshot::Rasterize(BLContext& context) const {
+
+	if (!mDamage.Is_Full()) {
+		// redraw just the damaged boxes; the primitives may stick out of a box, so the box is clipped
+		for (auto& box : mDamage.Get_Boxes()) {
+			const BLRectI rect(box.x0, box.y0, box.x1 - box.x0, box.y1 - box.y0);
+
+			context.save();
+			context.clipToRect(rect);
+
+			if (mStatic_Layer) {
+				context.setCompOp(BL_COMP_OP_SRC_COPY);
+				context.blitImage(BLPointI(box.x0, box.y0), mStatic_Layer->Get_Image(), rect);
+			}
+			else {
+				Fill_Background(context);
+			}
+
+			{
+				CPrimitive_Batch batch(context);
+
+				for (auto& prim : mPrimitives) {
+					// antialiasing may reach one pixel beyond the bounds
+					if (prim.bounds.x1 + 1 >= box.x0 && prim.bounds.x0 - 1 <= box.x1 && prim.bounds.y1 + 1 >= box.y0 && prim.bounds.y0 - 1 <= box.y1) {
+						batch.Add(prim);
+					}
+				}
+
+				batch.Flush();
+			}
+
+			context.restore();
+		}
+
+		return;
+	}
+
+	if (mStatic_Layer) {
+		// the layer already contains the background
+		context.setCompOp(BL_COMP_OP_SRC_COPY);
+		context.blitImage(BLPointI(0, 0), mStatic_Layer->Get_Image());
+	}
+	else {
+		Fill_Background(context);
+	}
+
+	CPrimitive_Batch batch(context);
+
+	// attributing the primitives to their objects is worth it only when someone is looking; consecutive primitives of the
+	// same object (e.g., the contents of a composite) make a single event. The primitives are batched just like without
+	// the profiler, so an event covers the batches flushed by adding the primitives, and a batch may contain primitives of
+	// the preceding objects as well
+	if (sProfiler.Is_Enabled()) {
+		for (size_t first = 0; first < mPrimitives.size();) {
+			const auto& prim = mPrimitives[first];
+
+			size_t last = first + 1;
+			while (last < mPrimitives.size() && mPrimitives[last].owner == prim.owner && mPrimitives[last].type == prim.type) {
+				last++;
+			}
+
+			CProfile_Scope scope(Raster_Categories[static_cast<size_t>(prim.type)],
+				(mOwner_Names && prim.owner < mOwner_Names->size()) ? (*mOwner_Names)[prim.owner] : Object_Type_Names[static_cast<size_t>(prim.type)]);
+
+			for (; first < last; first++) {
+				batch.Add(mPrimitives[first]);
+			}
+		}
+	}
+	else {
+		for (auto& prim : mPrimitives) {
+			batch.Add(prim);
+		}
+	}
+
+	CProfile_Scope scope("raster", "Flush batch");
+	batch.Flush();
+}
+
+void CFrame_Snapshot::Fill_Background(BLContext& context) {
+	// the context may be reused across frames, so the background must not depend on whatever was set before
+	context.setCompOp(BL_COMP_OP_SRC_COPY);
+	context.setFillStyle(BLRgba32(0xFF000000));
+	context.fillAll();
+}
+
+void CFrame_Snapshot::Draw_Primitive(BLContext& context, const TDraw_Primitive& prim) {
+
+	context.save();
+	context.transform(prim.transform);
+
+	context.setCompOp(BL_COMP_OP_SRC_OVER);
+	context.setFillStyle(BLRgba32(prim.fill));
+	context.setStrokeStyle(BLRgba32(prim.stroke));
+	context.setStrokeWidth(prim.strokeWidth);
+
+	switch (prim.type) {
+		case NObject_Type::Rectangle:
+		{
+			BLRect rect(0, 0, prim.width, prim.height);
+			context.strokeRect(rect);
+			context.fillRect(rect);
+			break;
+		}
+		case NObject_Type::Circle:
+		{
+			BLCircle circle(0, 0, prim.width);
+			context.strokeCircle(circle);
+			context.fillCircle(circle);
+			break;
+		}
+		default:
+			break;
+	}
+
+	context.restore();
+}
+
+BLBox CFrame_Snapshot::Get_Bounds(const TDraw_Primitive& prim) {
+	switch (prim.type) {
+		case NObject_Type::Rectangle:
+			return Get_Rectangle_Bounds(prim.transform, prim.width, prim.height, prim.strokeWidth);
+		case NObject_Type::Circle:
+			return Get_Circle_Bounds(prim.transform, prim.width, prim.strokeWidth);
+		default:
+			return Empty_Box();
+	}
+}
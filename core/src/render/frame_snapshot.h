@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <blend2d.h>
+
+#include "../parser_entities.h"
+#include "../entities/shared.h"
+#include "damage_region.h"
+
+/*
+ * A single drawing primitive with all of its parameters already resolved
+ */
+struct TDraw_Primitive {
+	NObject_Type type = NObject_Type::None;		// type of primitive (rectangle or circle)
+	BLMatrix2D transform;						// final (world) transformation of the primitive
+	rgb_t fill = 0;								// fill color
+	rgb_t stroke = 0;							// stroke color
+	double strokeWidth = 0;						// stroke width
+	double width = 0;							// rectangle width or circle radius
+	double height = 0;							// rectangle height (unused for circles)
+	BLBox bounds;								// conservative bounding box in canvas coordinates
+	size_t owner = 0;							// index of the scene entity, that recorded the primitive
+};
+
+class CStatic_Layer;
+
+/*
+ * Immutable snapshot of a single frame - the scene records it sequentially, so it can be
+ * rasterized later on any thread without touching the scene state
+ */
+class CFrame_Snapshot {
+	private:
+		// global index of the frame
+		size_t mFrame_Index = 0;
+		// layer with pre-rasterized static objects, drawn below all the primitives (may be empty)
+		std::shared_ptr<const CStatic_Layer> mStatic_Layer;
+		// primitives in drawing order
+		std::vector<TDraw_Primitive> mPrimitives;
+		// area of the frame to be redrawn; the rest of the target buffer is expected to contain valid pixels already
+		CDamage_Region mDamage;
+		// number of frames following this one, that are identical to it
+		size_t mRepeat_Count = 0;
+		// index of the scene entity recording primitives right now
+		size_t mOwner = 0;
+		// names of scene entities, so the rasterization of primitives may be attributed to them when profiling
+		std::shared_ptr<const std::vector<const char*>> mOwner_Names;
+		// number of times the primitive storage was (re)allocated
+		size_t mAllocations = 0;
+
+	public:
+		explicit CFrame_Snapshot(size_t frameIndex);
+
+		// adds a primitive to the end of drawing order
+		void Add_Primitive(const TDraw_Primitive& primitive);
+		// sets the scene entity, that records the following primitives
+		void Set_Owner(size_t owner);
+		// sets names of the scene entities (indexed by entity index)
+		void Set_Owner_Names(const std::shared_ptr<const std::vector<const char*>>& names);
+		// moves all recorded primitives out of the snapshot
+		std::vector<TDraw_Primitive> Take_Primitives();
+		// sets the static layer to be used as a base of the frame
+		void Set_Static_Layer(const std::shared_ptr<const CStatic_Layer>& layer);
+		// sets the area to be redrawn
+		void Set_Damage(const CDamage_Region& damage);
+		// retrieves the area to be redrawn
+		const CDamage_Region& Get_Damage() const;
+
+		// retrieves global frame index
+		size_t Get_Frame_Index() const;
+		// marks the next frame as identical to this one
+		void Add_Repeat();
+		// retrieves number of frames following this one, that are identical to it
+		size_t Get_Repeat_Count() const;
+		// retrieves the number of heap allocations made by the snapshot itself (excluding the snapshot object)
+		size_t Get_Allocation_Count() const;
+
+		// rasterizes the damaged area of the frame to given context
+		void Rasterize(BLContext& context) const;
+
+		// fills the whole canvas with the background
+		static void Fill_Background(BLContext& context);
+		// draws a single primitive
+		static void Draw_Primitive(BLContext& context, const TDraw_Primitive& prim);
+		// computes conservative bounding box of a primitive
+		static BLBox Get_Bounds(const TDraw_Primitive& prim);
+};
@@ -0,0 +1,448 @@
+#include "pipeline.h"
+
+#include <format>
+
+#include "../platform.h"
+#include "../profiler.h"
+
+#include <spdlog/spdlog.h>
+
+CRender_Pipeline::CRender_Pipeline(const TPipeline_Settings& settings) : mSettings(settings) {
+
+	mSettings.jobs = std::max(mSettings.jobs, static_cast<size_t>(1));
+	mSettings.channels = std::max(mSettings.channels, static_cast<size_t>(1));
+	// streamed frames are passed on straight from the rasterized buffers
+	mSettings.encoders = Is_Streamed() ? 0 : std::max(mSettings.encoders, static_cast<size_t>(1));
+
+	mNext_Output = mSettings.firstFrame;
+
+	// allow every worker and encoder to have one frame queued ahead, so they never starve; every channel needs at least two
+	// buffers, so its producer may record a frame while the previous one is being rendered
+	const size_t threads = mSettings.jobs + mSettings.encoders;
+	const size_t lanes = std::max((threads * 2 + mSettings.channels - 1) / mSettings.channels, static_cast<size_t>(2));
+
+	// every frame in flight may hold a buffer, so the pool never runs dry
+	mPool = std::make_unique<CFrame_Pool>(mSettings.width, mSettings.height, lanes * mSettings.channels);
+
+	mChannels.resize(mSettings.channels);
+	for (size_t i = 0; i < mChannels.size(); i++) {
+		mChannels[i].firstBuffer = i * lanes;
+		mChannels[i].bufferCount = lanes;
+
+		// the buffers contain nothing useful yet
+		mChannels[i].laneDamage.resize(lanes, CDamage_Region(mSettings.width, mSettings.height));
+		for (auto& lane : mChannels[i].laneDamage) {
+			lane.Set_Full();
+		}
+	}
+
+	if (!Is_Streamed()) {
+		mSink = CFrame_Sink::Create(mSettings.sink);
+		if (!mSink) {
+			mFailed = true;
+		}
+	}
+
+	mStart_Time = std::chrono::steady_clock::now();
+	mEnd_Time = mStart_Time;
+
+	for (size_t i = 0; i < mSettings.jobs; i++) {
+		mWorkers.emplace_back(&CRender_Pipeline::Worker_Loop, this, i);
+	}
+
+	for (size_t i = 0; i < mSettings.encoders; i++) {
+		mEncoders.emplace_back(&CRender_Pipeline::Encoder_Loop, this, i);
+	}
+}
+
+CRender_Pipeline::~CRender_Pipeline() {
+	Finish();
+}
+
+bool CRender_Pipeline::Submit(size_t channel, std::unique_ptr<CFrame_Snapshot> snapshot) {
+
+	auto& chan = mChannels[channel];
+
+	// the channel buffers are used in round-robin fashion, so the target buffer holds the frame submitted a channel-size ago;
+	// the frames may finish in any order, so the pool makes sure the frames are drawn to the buffer in this order as well
+	const size_t turn = chan.submitted / chan.bufferCount;
+	const size_t lane = chan.submitted++ % chan.bufferCount;
+
+	if (mSettings.incremental) {
+		// ... so it needs all the damage since then
+		for (auto& damage : chan.laneDamage) {
+			damage.Add(snapshot->Get_Damage());
+		}
+
+		snapshot->Set_Damage(chan.laneDamage[lane]);
+		chan.laneDamage[lane].Clear();
+	}
+	else {
+		CDamage_Region full(mSettings.width, mSettings.height);
+		full.Set_Full();
+		snapshot->Set_Damage(full);
+	}
+
+	std::unique_lock lck(mMutex);
+
+	// the previous frame rendered to the target buffer must be written, before the buffer can be reused
+	mSlot_Available.wait(lck, [this, &chan] { return chan.inFlight < chan.bufferCount || mFailed; });
+
+	// other producers may have stopped already, so the ordered output could wait for their frames forever
+	if (mFailed) {
+		return false;
+	}
+
+	chan.inFlight++;
+	mIn_Flight++;
+	// the first round through the channel buffers still has everything to allocate and all the frames to draw in full
+	mQueue.push_back({ channel, chan.firstBuffer + lane, turn, std::move(snapshot), chan.submitted <= chan.bufferCount });
+	mWork_Available.notify_one();
+
+	return !mFailed;
+}
+
+bool CRender_Pipeline::Finish() {
+	{
+		std::unique_lock lck(mMutex);
+		mSlot_Available.wait(lck, [this] { return mIn_Flight == 0; });
+
+		mFinishing = true;
+		mWork_Available.notify_all();
+		mEncode_Available.notify_all();
+	}
+
+	for (auto& worker : mWorkers) {
+		if (worker.joinable())
+			worker.join();
+	}
+
+	for (auto& encoder : mEncoders) {
+		if (encoder.joinable())
+			encoder.join();
+	}
+
+	mWorkers.clear();
+	mEncoders.clear();
+
+	// the frames are done once they are on the storage
+	if (mSink) {
+		if (!mSink->Finish()) {
+			mFailed = true;
+		}
+		mEnd_Time = std::chrono::steady_clock::now();
+	}
+
+	return !mFailed;
+}
+
+void CRender_Pipeline::Report() const {
+	const double seconds = std::chrono::duration<double>(mEnd_Time - mStart_Time).count();
+	const double fps = (seconds > 0) ? static_cast<double>(mFrames_Written) / seconds : 0.0;
+
+	spdlog::info("Rendered {} frames in {:.2f} s ({:.2f} fps), {} of them reused from the previous frame", mFrames_Written, seconds, fps, mFrames_Deduplicated);
+	spdlog::info("Frame pool: {} buffers ({:.1f} MB), {} buffer allocations for {} frames; peak memory usage {:.1f} MB",
+		mPool->Get_Buffer_Count(), static_cast<double>(mPool->Get_Memory_Size()) / (1024.0 * 1024.0),
+		mPool->Get_Allocation_Count(), mPool->Get_Borrow_Count(),
+		static_cast<double>(Get_Peak_Memory_Usage()) / (1024.0 * 1024.0));
+	spdlog::info("Frame allocations (snapshots, primitive storage, encode buffers, output queue): {} in total, {:.2f} per frame after the warm-up ({} frames)",
+		mTotal_Allocations, (mSteady_Frames > 0) ? static_cast<double>(mSteady_Allocations) / static_cast<double>(mSteady_Frames) : 0.0, mSteady_Frames);
+
+	if (mSink) {
+		const auto stats = mSink->Get_Statistics();
+		const double megabytes = static_cast<double>(stats.bytes) / (1024.0 * 1024.0);
+
+		spdlog::info("Frame writes ({}): {} files, {:.1f} MB in {:.2f} s of writing ({:.1f} MB/s); at most {:.1f} MB queued, encoders blocked for {:.2f} s",
+			mSink->Get_Name(), stats.files, megabytes, stats.busySeconds, (stats.busySeconds > 0) ? megabytes / stats.busySeconds : 0.0,
+			static_cast<double>(stats.peakPendingBytes) / (1024.0 * 1024.0), stats.blockedSeconds);
+	}
+}
+
+bool CRender_Pipeline::Is_Pipe_Broken() const {
+	return mPipe_Broken;
+}
+
+void CRender_Pipeline::Worker_Loop(size_t workerIndex) {
+
+	sProfiler.Set_Thread_Name(std::format("Render worker {}", workerIndex));
+
+	while (true) {
+		TQueued_Frame queued;
+
+		{
+			std::unique_lock lck(mMutex);
+			mWork_Available.wait(lck, [this] { return !mQueue.empty() || mFinishing; });
+
+			if (mQueue.empty()) {
+				return;
+			}
+
+			queued = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		auto& snapshot = queued.snapshot;
+
+		TRendered_Frame frame;
+		frame.channel = queued.channel;
+		frame.buffer = mPool->Acquire(queued.buffer, queued.turn);
+		frame.repeat = snapshot->Get_Repeat_Count();
+		frame.valid = true;
+		frame.warmup = queued.warmup;
+		// the snapshot object itself and its primitive storage
+		frame.allocations = 1 + snapshot->Get_Allocation_Count();
+
+		{
+			CProfile_Scope scope("raster", "Rasterize");
+			snapshot->Rasterize(frame.buffer->Get_Context());
+			frame.buffer->Sync();
+		}
+
+		// streamed output reads directly from the pooled buffer, which is returned only after it's written
+		if (Is_Streamed()) {
+			Output(snapshot->Get_Frame_Index(), std::move(frame));
+			continue;
+		}
+
+		std::unique_lock lck(mMutex);
+		mEncode_Queue.emplace_back(snapshot->Get_Frame_Index(), std::move(frame));
+		mEncode_Available.notify_one();
+	}
+}
+
+void CRender_Pipeline::Encoder_Loop(size_t encoderIndex) {
+
+	sProfiler.Set_Thread_Name(std::format("Encoder {}", encoderIndex));
+
+	auto encoder = CFrame_Encoder::Create(mSettings.encoder);
+
+	while (true) {
+		std::pair<size_t, TRendered_Frame> queued;
+
+		{
+			std::unique_lock lck(mMutex);
+			mEncode_Available.wait(lck, [this] { return !mEncode_Queue.empty() || mFinishing; });
+
+			if (mEncode_Queue.empty()) {
+				return;
+			}
+
+			queued = std::move(mEncode_Queue.front());
+			mEncode_Queue.pop_front();
+		}
+
+		auto& [frameIndex, frame] = queued;
+
+		{
+			CProfile_Scope scope("encode", "Encode frame");
+
+			const size_t capacity = frame.encoded.capacity();
+
+			if (!encoder || !encoder->Encode(frame.buffer->Get_Image(), frame.encoded)) {
+				spdlog::error("Cannot encode frame {}", frameIndex);
+				frame.valid = false;
+			}
+
+			// the encoded data is handed over to the sink, so the encode buffer is allocated anew for every frame
+			if (frame.encoded.capacity() != capacity) {
+				frame.allocations++;
+			}
+		}
+
+		// the encoded data is all we need from now on
+		Release_Buffer(frame);
+
+		Output(frameIndex, std::move(frame));
+	}
+}
+
+void CRender_Pipeline::Output(size_t frameIndex, TRendered_Frame&& frame) {
+
+	// the stream consumers expect the frames in order; the archive is written in order as well, so it's read sequentially
+	if (Is_Streamed() || mSettings.imageStream || !mSettings.sink.archive.empty()) {
+		Output_Ordered(frameIndex, std::move(frame));
+		return;
+	}
+
+	// every image file is named after its frame, so the files may be handed over to the sink in any order (by any encoder)
+	const bool ok = Write_Frame(frameIndex, frame);
+
+	std::unique_lock lck(mMutex);
+	Frame_Done(frame, ok);
+}
+
+void CRender_Pipeline::Output_Ordered(size_t frameIndex, TRendered_Frame&& frame) {
+	std::unique_lock lck(mMutex);
+
+	// the map node holding the frame until its turn
+	frame.allocations++;
+	mPending_Output.emplace(frameIndex, std::move(frame));
+
+	// someone else is writing right now - they will pick this frame up when its turn comes
+	if (mWriting) {
+		return;
+	}
+
+	mWriting = true;
+
+	// after a failure, some frames will never arrive; the pending ones are just discarded, so the producers are not blocked
+	while (!mPending_Output.empty() && (mPending_Output.begin()->first == mNext_Output || mFailed)) {
+		auto node = mPending_Output.extract(mPending_Output.begin());
+		const bool discard = mFailed;
+
+		lck.unlock();
+		const bool ok = !discard && Write_Frame(node.key(), node.mapped());
+		Release_Buffer(node.mapped());
+		lck.lock();
+
+		mNext_Output += 1 + node.mapped().repeat;
+		Frame_Done(node.mapped(), ok);
+	}
+
+	mWriting = false;
+}
+
+void CRender_Pipeline::Frame_Done(const TRendered_Frame& frame, bool ok) {
+
+	if (ok) {
+		mFrames_Written += 1 + frame.repeat;
+		mFrames_Deduplicated += frame.repeat;
+	}
+	else {
+		mFailed = true;
+	}
+
+	mTotal_Allocations += frame.allocations;
+	if (!frame.warmup) {
+		mSteady_Frames++;
+		mSteady_Allocations += frame.allocations;
+	}
+
+	mChannels[frame.channel].inFlight--;
+	mIn_Flight--;
+	mEnd_Time = std::chrono::steady_clock::now();
+
+	mSlot_Available.notify_all();
+}
+
+bool CRender_Pipeline::Write_Frame(size_t frameIndex, TRendered_Frame& frame) {
+
+	CProfile_Scope scope("write", "Write frame");
+
+	if (!frame.valid) {
+		return false;
+	}
+
+	if (mSettings.videoEncoder) {
+		return mSettings.videoEncoder->Encode(frameIndex, frame.buffer->Get_Image(), frame.repeat);
+	}
+
+	if (mSettings.rawStream) {
+		// the encoder needs every frame, so just send the same buffer again
+		for (size_t i = 0; i <= frame.repeat; i++) {
+			if (!Write_Raw(frameIndex + i, frame.buffer->Get_Image())) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	if (!mSink) {
+		return false;
+	}
+
+	// piped before the data is handed over to the sink; the frame files are complete anyway, so a broken pipe just means
+	// the video has to be stitched from them afterwards
+	if (mSettings.imageStream && !mPipe_Broken && !Write_Piped(frameIndex, frame)) {
+		spdlog::warn("Frames are no longer piped to the encoder, the video will be stitched after rendering");
+		mPipe_Broken = true;
+	}
+
+	TSink_File file;
+	file.frame = frameIndex;
+	file.repeat = frame.repeat;
+	file.data = std::move(frame.encoded);
+
+	// the archive indexes the repetitions itself
+	if (!mSettings.sink.archive.empty()) {
+		return mSink->Write(std::move(file));
+	}
+
+	const char* extension = CFrame_Encoder::Get_Extension(mSettings.encoder.format);
+
+	file.path = mSettings.outputDirectory / std::format("frame_{:06}.{}", frameIndex, extension);
+
+	for (size_t i = 1; i <= frame.repeat; i++) {
+		file.links.push_back(mSettings.outputDirectory / std::format("frame_{:06}.{}", frameIndex + i, extension));
+	}
+
+	// blocks only while the sink memory budget is used up
+	return mSink->Write(std::move(file));
+}
+
+bool CRender_Pipeline::Write_Piped(size_t frameIndex, const TRendered_Frame& frame) {
+
+	const auto* data = reinterpret_cast<const char*>(frame.encoded.data());
+	const auto size = static_cast<std::streamsize>(frame.encoded.size());
+
+	try {
+		// the pipe demuxer has no notion of repetitions; the write blocks, until ffmpeg consumes the data
+		for (size_t i = 0; i <= frame.repeat; i++) {
+			mSettings.imageStream->write(data, size);
+		}
+	}
+	catch (std::exception& ex) {
+		spdlog::warn("Cannot pipe frame {} to the encoder: {}", frameIndex, ex.what());
+		return false;
+	}
+
+	if (!*mSettings.imageStream) {
+		spdlog::warn("Cannot pipe frame {} to the encoder", frameIndex);
+		return false;
+	}
+
+	return true;
+}
+
+bool CRender_Pipeline::Write_Raw(size_t frameIndex, const BLImage& image) {
+
+	BLImageData data;
+	if (image.getData(&data) != BL_SUCCESS) {
+		spdlog::error("Cannot access pixel data of frame {}", frameIndex);
+		return false;
+	}
+
+	// PRGB32 is stored as BGRA in memory; the frames are opaque (the background is filled first), so premultiplication does not matter
+	const auto rowBytes = static_cast<std::streamsize>(data.size.w) * 4;
+	const auto* pixels = static_cast<const char*>(data.pixelData);
+
+	try {
+		// the write blocks, until ffmpeg consumes the data; this stalls the in-order output, which in turn blocks new submissions
+		if (data.stride == rowBytes) {
+			mSettings.rawStream->write(pixels, rowBytes * data.size.h);
+		}
+		else {
+			for (int y = 0; y < data.size.h; y++) {
+				mSettings.rawStream->write(pixels + y * data.stride, rowBytes);
+			}
+		}
+	}
+	catch (std::exception& ex) {
+		spdlog::error("Cannot write frame {} to the encoder: {}", frameIndex, ex.what());
+		return false;
+	}
+
+	if (!*mSettings.rawStream) {
+		spdlog::error("Cannot write frame {} to the encoder", frameIndex);
+		return false;
+	}
+
+	return true;
+}
+
+void CRender_Pipeline::Release_Buffer(TRendered_Frame& frame) {
+	if (frame.buffer) {
+		mPool->Release(frame.buffer);
+		frame.buffer = nullptr;
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <ostream>
+
+#include <blend2d.h>
+
+#include "frame_snapshot.h"
+#include "frame_pool.h"
+#include "frame_encoder.h"
+#include "frame_sink.h"
+#include "video_encoder.h"
+
+/*
+ * Render pipeline settings
+ */
+struct TPipeline_Settings {
+	size_t jobs = 1;							// number of worker threads
+	size_t encoders = 1;						// number of encoder threads (image file output only)
+	size_t channels = 1;						// number of producers submitting frames concurrently
+	int width = 0;								// canvas width
+	int height = 0;								// canvas height
+	std::filesystem::path outputDirectory;		// directory to write the frames to
+	std::ostream* rawStream = nullptr;			// stream to write raw frames to; if not set, frames are written as image files to the output directory
+	CVideo_Encoder* videoEncoder = nullptr;		// in-process encoder to pass the frames to, instead of the raw stream or image files
+	std::ostream* imageStream = nullptr;		// stream to pipe the encoded image files to as well, in frame order (e.g., to ffmpeg stitching the video meanwhile)
+	TEncoder_Settings encoder;					// format of the image files
+	TSink_Settings sink;						// asynchronous writing of the image files
+	bool incremental = false;					// redraw only the damaged areas of frames?
+	size_t firstFrame = 0;						// index of the first frame to be submitted (when rendering just a part of the video)
+};
+
+/*
+ * Rendered frame waiting for output
+ */
+struct TRendered_Frame {
+	size_t channel = 0;					// channel the frame was submitted through
+	CFrame_Buffer* buffer = nullptr;	// rasterized frame borrowed from the pool (used for streamed output)
+	std::vector<uint8_t> encoded;		// encoded frame (used for image file output)
+	size_t repeat = 0;					// number of identical frames following this one
+	bool valid = false;					// was the frame rendered successfully?
+	bool warmup = false;				// was the frame rendered while the pipeline was warming up?
+	size_t allocations = 0;				// heap allocations made for the frame on its way through the pipeline
+};
+
+/*
+ * Snapshot queued for rendering
+ */
+struct TQueued_Frame {
+	size_t channel = 0;								// channel the frame was submitted through
+	size_t buffer = 0;								// index of the pool buffer to render the frame to
+	size_t turn = 0;								// number of frames rendered to the buffer before this one
+	std::unique_ptr<CFrame_Snapshot> snapshot;		// the frame to be rendered
+	bool warmup = false;							// is the target buffer used for the first time?
+};
+
+/*
+ * Submission channel - every producer submitting frames concurrently (e.g., a scene rendered in parallel to others)
+ * has its own, so it has its own set of pool buffers and damage tracking
+ */
+struct TPipeline_Channel {
+	size_t firstBuffer = 0;						// index of the first pool buffer owned by the channel
+	size_t bufferCount = 0;						// number of pool buffers owned by the channel (the maximum of frames in flight)
+	size_t submitted = 0;						// number of frames submitted through the channel so far
+	size_t inFlight = 0;						// number of frames submitted through the channel, but not written yet
+	std::vector<CDamage_Region> laneDamage;		// damage accumulated for every channel buffer since the frame it holds
+};
+
+/*
+ * Frame rendering pipeline - a pool of workers rasterizes frame snapshots in parallel; the frames are then written out
+ * either as image files, or as raw pixel data to a stream or an in-process video encoder (strictly in frame order)
+ *
+ * Image files are encoded (and written) by a separate pool of encoder threads, so the encoding of a frame overlaps with
+ * the rasterization of the following ones; a frame keeps its pool buffer until it's encoded
+ */
+class CRender_Pipeline {
+	private:
+		// pipeline settings
+		TPipeline_Settings mSettings;
+		// preallocated frame buffers, split among channels; there is one for every frame in flight
+		std::unique_ptr<CFrame_Pool> mPool;
+
+		// guards all the state below (except for the channel submission state, that is touched only by the channel producer)
+		std::mutex mMutex;
+		// signalled when a snapshot is queued or the pipeline is finishing
+		std::condition_variable mWork_Available;
+		// signalled when a frame leaves the pipeline
+		std::condition_variable mSlot_Available;
+
+		// submission channels
+		std::vector<TPipeline_Channel> mChannels;
+		// snapshots waiting for a worker
+		std::deque<TQueued_Frame> mQueue;
+		// signalled when a rasterized frame is queued for encoding or the pipeline is finishing
+		std::condition_variable mEncode_Available;
+		// rasterized frames (with their frame indices) waiting for an encoder
+		std::deque<std::pair<size_t, TRendered_Frame>> mEncode_Queue;
+		// rendered frames waiting for their turn to be written (streamed, piped or archived output only)
+		std::map<size_t, TRendered_Frame> mPending_Output;
+		// index of the next frame to be written (streamed, piped or archived output only)
+		size_t mNext_Output = 0;
+		// number of frames submitted, but not written yet
+		size_t mIn_Flight = 0;
+		// is there a thread writing frames right now?
+		bool mWriting = false;
+		// is the pipeline shutting down?
+		bool mFinishing = false;
+		// did any frame fail to render or write?
+		bool mFailed = false;
+		// did piping to the image stream fail? the frames are still written, just not piped anymore (touched only by the writer)
+		bool mPipe_Broken = false;
+
+		// writes the image files, so the encoders do not wait for the storage
+		std::unique_ptr<CFrame_Sink> mSink;
+
+		// worker threads
+		std::vector<std::thread> mWorkers;
+		// encoder threads
+		std::vector<std::thread> mEncoders;
+
+		// number of frames written
+		size_t mFrames_Written = 0;
+		// number of frames written as a copy of the previous frame
+		size_t mFrames_Deduplicated = 0;
+		// number of frames, that left the pipeline after the warm-up (every pool buffer was used once)
+		size_t mSteady_Frames = 0;
+		// heap allocations made for the frames that left the pipeline after the warm-up
+		size_t mSteady_Allocations = 0;
+		// heap allocations made for all the frames
+		size_t mTotal_Allocations = 0;
+		// time the pipeline was started
+		std::chrono::steady_clock::time_point mStart_Time;
+		// time the last frame was written
+		std::chrono::steady_clock::time_point mEnd_Time;
+
+		// are the frames passed in order to a video encoder (instead of being written as image files)?
+		bool Is_Streamed() const {
+			return mSettings.rawStream || mSettings.videoEncoder;
+		}
+
+	protected:
+		// worker thread body
+		void Worker_Loop(size_t workerIndex);
+		// encoder thread body
+		void Encoder_Loop(size_t encoderIndex);
+		// hands a rendered frame over to output
+		void Output(size_t frameIndex, TRendered_Frame&& frame);
+		// writes all frames, that are next in order (streamed, piped or archived output only)
+		void Output_Ordered(size_t frameIndex, TRendered_Frame&& frame);
+		// accounts a frame leaving the pipeline; must be called with the mutex locked
+		void Frame_Done(const TRendered_Frame& frame, bool ok);
+		// writes a single rendered frame, including its repetitions; image files are handed over to the sink with the encoded data
+		bool Write_Frame(size_t frameIndex, TRendered_Frame& frame);
+		// pipes an encoded frame, including its repetitions, to the image stream
+		bool Write_Piped(size_t frameIndex, const TRendered_Frame& frame);
+		// writes raw pixels of a frame to the raw stream
+		bool Write_Raw(size_t frameIndex, const BLImage& image);
+		// returns the frame buffer of given frame (if any) back to the pool
+		void Release_Buffer(TRendered_Frame& frame);
+
+	public:
+		explicit CRender_Pipeline(const TPipeline_Settings& settings);
+		virtual ~CRender_Pipeline();
+
+		// submits a frame snapshot for rendering through given channel; blocks while the channel is full
+		// every channel must be used by a single thread at a time
+		bool Submit(size_t channel, std::unique_ptr<CFrame_Snapshot> snapshot);
+		// waits for all submitted frames to be written and stops the workers
+		bool Finish();
+		// prints out the throughput report
+		void Report() const;
+		// did piping to the image stream fail, so the stream did not get all the frames?
+		bool Is_Pipe_Broken() const;
+};
@@ -0,0 +1,172 @@
+#include "primitive_batch.h"
+#include "affine_kernel.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	// tolerance of the similarity transformation test
+	constexpr double Similarity_Epsilon = 1e-9;
+
+	// is the color fully transparent?
+	bool Is_Transparent(rgb_t color) {
+		return (color >> 24) == 0;
+	}
+}
+
+CPrimitive_Batch::CPrimitive_Batch(BLContext& context) : mContext(context) {
+	mGrid_Width = (static_cast<int>(std::ceil(context.targetWidth())) >> Cell_Shift) + 1;
+	mGrid_Height = (static_cast<int>(std::ceil(context.targetHeight())) >> Cell_Shift) + 1;
+	mOccupied.resize(static_cast<size_t>(mGrid_Width) * static_cast<size_t>(mGrid_Height), 0);
+}
+
+CPrimitive_Batch::~CPrimitive_Batch() {
+	Flush();
+}
+
+bool CPrimitive_Batch::Get_Cells(const BLBox& bounds, int& x0, int& y0, int& x1, int& y1) const {
+
+	const double maxX = static_cast<double>(mGrid_Width << Cell_Shift);
+	const double maxY = static_cast<double>(mGrid_Height << Cell_Shift);
+
+	// antialiasing may reach one pixel beyond the bounds
+	if (!(bounds.x1 + 1 >= 0 && bounds.y1 + 1 >= 0 && bounds.x0 - 1 < maxX && bounds.y0 - 1 < maxY)) {
+		return false;
+	}
+
+	x0 = static_cast<int>(std::clamp(bounds.x0 - 1, 0.0, maxX - 1)) >> Cell_Shift;
+	y0 = static_cast<int>(std::clamp(bounds.y0 - 1, 0.0, maxY - 1)) >> Cell_Shift;
+	x1 = static_cast<int>(std::clamp(bounds.x1 + 1, 0.0, maxX - 1)) >> Cell_Shift;
+	y1 = static_cast<int>(std::clamp(bounds.y1 + 1, 0.0, maxY - 1)) >> Cell_Shift;
+
+	return true;
+}
+
+bool CPrimitive_Batch::Is_Occupied(int x0, int y0, int x1, int y1) const {
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			if (mOccupied[y * mGrid_Width + x]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CPrimitive_Batch::Occupy(int x0, int y0, int x1, int y1) {
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			auto& cell = mOccupied[y * mGrid_Width + x];
+			if (!cell) {
+				cell = 1;
+				mTouched.push_back(y * mGrid_Width + x);
+			}
+		}
+	}
+}
+
+void CPrimitive_Batch::Apply_Style(const TBatch_Style& style) {
+
+	if (!mContext_Style_Valid) {
+		mContext.setCompOp(BL_COMP_OP_SRC_OVER);
+		mContext.setFillStyle(BLRgba32(style.fill));
+		mContext.setStrokeStyle(BLRgba32(style.stroke));
+		mContext.setStrokeWidth(style.strokeWidth);
+		mContext_Style = style;
+		mContext_Style_Valid = true;
+		return;
+	}
+
+	if (mContext_Style.fill != style.fill) {
+		mContext.setFillStyle(BLRgba32(style.fill));
+	}
+	if (mContext_Style.stroke != style.stroke) {
+		mContext.setStrokeStyle(BLRgba32(style.stroke));
+	}
+	if (mContext_Style.strokeWidth != style.strokeWidth) {
+		mContext.setStrokeWidth(style.strokeWidth);
+	}
+
+	mContext_Style = style;
+}
+
+void CPrimitive_Batch::Add(const TDraw_Primitive& prim) {
+
+	const BLMatrix2D& m = prim.transform;
+	const double scale = std::sqrt(std::abs(m.m00 * m.m11 - m.m01 * m.m10));
+
+	// the geometry is moved to canvas coordinates, where the stroke is no longer transformed; that is the same only for
+	// similarity transformations (uniform scale, rotation and translation), anything else is drawn on its own
+	const bool similar = std::abs(m.m00 - m.m11) <= Similarity_Epsilon * (1.0 + scale) && std::abs(m.m01 + m.m10) <= Similarity_Epsilon * (1.0 + scale);
+	if (!similar || (prim.type != NObject_Type::Rectangle && prim.type != NObject_Type::Circle)) {
+		Flush();
+		CFrame_Snapshot::Draw_Primitive(mContext, prim);
+		// the primitive is drawn within save/restore, so the context style stays as it was
+		return;
+	}
+
+	TBatch_Style style{ prim.fill, prim.stroke, prim.strokeWidth * scale };
+	if (Is_Transparent(style.stroke) || !(style.strokeWidth > 0)) {
+		style.stroke = 0;
+		style.strokeWidth = 0;
+	}
+
+	// nothing would be drawn at all
+	if (Is_Transparent(style.fill) && style.strokeWidth == 0) {
+		return;
+	}
+
+	int x0, y0, x1, y1;
+	if (!Get_Cells(prim.bounds, x0, y0, x1, y1)) {
+		return;
+	}
+
+	if (mCount > 0 && (!(style == mStyle) || Is_Occupied(x0, y0, x1, y1))) {
+		Flush();
+	}
+
+	if (prim.type == NObject_Type::Rectangle) {
+		BLPoint corners[4];
+		Map_Rectangle(m, prim.width, prim.height, corners);
+
+		mPath.moveTo(corners[0].x, corners[0].y);
+		mPath.lineTo(corners[1].x, corners[1].y);
+		mPath.lineTo(corners[2].x, corners[2].y);
+		mPath.lineTo(corners[3].x, corners[3].y);
+		mPath.close();
+	}
+	else {
+		// a circle stays a circle under a similarity transformation
+		mPath.addCircle(BLCircle(m.m20, m.m21, prim.width * scale));
+	}
+
+	Occupy(x0, y0, x1, y1);
+	mStyle = style;
+	mCount++;
+}
+
+void CPrimitive_Batch::Flush() {
+
+	if (mCount == 0) {
+		return;
+	}
+
+	Apply_Style(mStyle);
+
+	// the same order as drawing a single primitive; the primitives do not overlap, so the order among them does not matter
+	if (mStyle.strokeWidth > 0) {
+		mContext.strokePath(mPath);
+	}
+	if (!Is_Transparent(mStyle.fill)) {
+		mContext.fillPath(mPath);
+	}
+
+	mPath.clear();
+
+	for (int idx : mTouched) {
+		mOccupied[idx] = 0;
+	}
+	mTouched.clear();
+
+	mCount = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <blend2d.h>
+
+#include "frame_snapshot.h"
+
+/*
+ * Batched primitive renderer - consecutive primitives of the same style are transformed to canvas coordinates and
+ * drawn as a single path, so the context state is set once per batch instead of once per primitive
+ *
+ * A primitive joins the batch only if it does not touch any pixel of the primitives already in the batch; then the order,
+ * in which they are drawn, does not matter and the result is identical to drawing them one by one
+ */
+class CPrimitive_Batch {
+	private:
+		// style shared by all primitives of a batch
+		struct TBatch_Style {
+			rgb_t fill = 0;							// fill color
+			rgb_t stroke = 0;						// stroke color
+			double strokeWidth = 0;					// stroke width in canvas coordinates (0 = no stroke)
+
+			bool operator==(const TBatch_Style&) const = default;
+		};
+
+		// size of an occupancy grid cell in pixels (as a shift)
+		static constexpr int Cell_Shift = 4;
+
+		// target context
+		BLContext& mContext;
+		// occupancy grid dimensions
+		int mGrid_Width = 0, mGrid_Height = 0;
+		// occupancy grid - cells touched by primitives of the current batch
+		std::vector<uint8_t> mOccupied;
+		// indices of occupied cells, so the grid may be cleared quickly
+		std::vector<int> mTouched;
+
+		// geometry of the current batch in canvas coordinates
+		BLPath mPath;
+		// style of the current batch
+		TBatch_Style mStyle;
+		// number of primitives in the current batch
+		size_t mCount = 0;
+		// style, that is currently set to the context (if any)
+		TBatch_Style mContext_Style;
+		bool mContext_Style_Valid = false;
+
+	protected:
+		// retrieves the range of grid cells covered by the bounds; returns false, if the bounds are outside of the canvas
+		bool Get_Cells(const BLBox& bounds, int& x0, int& y0, int& x1, int& y1) const;
+		// does the box touch a primitive of the current batch?
+		bool Is_Occupied(int x0, int y0, int x1, int y1) const;
+		// marks the box as touched by the current batch
+		void Occupy(int x0, int y0, int x1, int y1);
+		// sets the style to the context, unless it is set already
+		void Apply_Style(const TBatch_Style& style);
+
+	public:
+		explicit CPrimitive_Batch(BLContext& context);
+		~CPrimitive_Batch();
+
+		CPrimitive_Batch(const CPrimitive_Batch&) = delete;
+		CPrimitive_Batch& operator=(const CPrimitive_Batch&) = delete;
+
+		// adds a primitive to the end of drawing order; the primitive may be drawn later, when the batch is flushed
+		void Add(const TDraw_Primitive& prim);
+		// draws the current batch
+		void Flush();
+};
@@ -0,0 +1,33 @@
+#include "static_layer.h"
+#include "primitive_batch.h"
+
+CStatic_Layer::CStatic_Layer(int width, int height, std::vector<TDraw_Primitive>&& primitives)
+	: mWidth(width), mHeight(height), mPrimitives(std::move(primitives)) {
+	//
+}
+
+size_t CStatic_Layer::Get_Primitive_Count() const {
+	return mPrimitives.size();
+}
+
+const BLImage& CStatic_Layer::Get_Image() const {
+
+	std::call_once(mRasterized, [this]() {
+		mImage.create(mWidth, mHeight, BL_FORMAT_PRGB32);
+
+		BLContext ctx(mImage);
+
+		CFrame_Snapshot::Fill_Background(ctx);
+		{
+			CPrimitive_Batch batch(ctx);
+			for (auto& prim : mPrimitives) {
+				batch.Add(prim);
+			}
+			batch.Flush();
+		}
+
+		ctx.end();
+	});
+
+	return mImage;
+}
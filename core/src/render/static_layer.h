@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <blend2d.h>
+
+#include "frame_snapshot.h"
+
+/*
+ * Pre-rasterized layer of objects, that do not change between frames; it serves as a base of every frame
+ * until the set of static objects changes
+ */
+class CStatic_Layer {
+	private:
+		// canvas dimensions
+		int mWidth = 0, mHeight = 0;
+		// primitives of all static objects in drawing order
+		std::vector<TDraw_Primitive> mPrimitives;
+
+		// ensures the layer is rasterized just once, by the first worker that needs it
+		mutable std::once_flag mRasterized;
+		// rasterized layer, including the background
+		mutable BLImage mImage;
+
+	public:
+		CStatic_Layer(int width, int height, std::vector<TDraw_Primitive>&& primitives);
+
+		// retrieves number of primitives in the layer
+		size_t Get_Primitive_Count() const;
+		// retrieves the rasterized layer; the layer is rasterized on first use (thread safe)
+		const BLImage& Get_Image() const;
+};
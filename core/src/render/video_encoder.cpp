@@ -0,0 +1,277 @@
+#include "video_encoder.h"
+
+#include <string>
+
+#ifdef VIDGENX_HAVE_LIBAV
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "../profiler.h"
+
+#ifdef VIDGENX_HAVE_LIBAV
+namespace {
+	// retrieves the description of a libav error code
+	std::string Describe_Error(int error) {
+		char buffer[AV_ERROR_MAX_STRING_SIZE] = {};
+		av_strerror(error, buffer, sizeof(buffer));
+		return buffer;
+	}
+
+	/*
+	 * Encoder built on libavcodec and libavformat; the codec is the default one of the container (H.264 for MP4 and MKV,
+	 * when libav is built with libx264), the frames are converted to YUV 4:2:0 like the ffmpeg binary is told to
+	 */
+	class CLibav_Video_Encoder : public CVideo_Encoder {
+		private:
+			TVideo_Settings mSettings;
+
+			AVFormatContext* mFormat = nullptr;
+			AVCodecContext* mCodec = nullptr;
+			AVStream* mStream = nullptr;
+			SwsContext* mScaler = nullptr;
+			// converted frame sent to the encoder
+			AVFrame* mFrame = nullptr;
+			AVPacket* mPacket = nullptr;
+
+			// presentation timestamp of the next frame (in frames)
+			int64_t mNext_Pts = 0;
+			// was the header written (and so the trailer has to be)?
+			bool mHeader_Written = false;
+			// was the video completed?
+			bool mFinished = false;
+
+			// writes all the packets the encoder has ready
+			bool Drain() {
+				while (true) {
+					const int ret = avcodec_receive_packet(mCodec, mPacket);
+					if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+						return true;
+					}
+					if (ret < 0) {
+						spdlog::error("Cannot encode video: {}", Describe_Error(ret));
+						return false;
+					}
+
+					av_packet_rescale_ts(mPacket, mCodec->time_base, mStream->time_base);
+					mPacket->stream_index = mStream->index;
+
+					// the muxer takes the packet over
+					const int written = av_interleaved_write_frame(mFormat, mPacket);
+					if (written < 0) {
+						spdlog::error("Cannot write video {}: {}", mSettings.path.string(), Describe_Error(written));
+						return false;
+					}
+				}
+			}
+
+		public:
+			explicit CLibav_Video_Encoder(const TVideo_Settings& settings) : mSettings(settings) {
+				//
+			}
+
+			~CLibav_Video_Encoder() override {
+				if (mHeader_Written && !mFinished) {
+					av_write_trailer(mFormat);
+				}
+				if (mFormat && mFormat->pb && !(mFormat->oformat->flags & AVFMT_NOFILE)) {
+					avio_closep(&mFormat->pb);
+				}
+
+				av_packet_free(&mPacket);
+				av_frame_free(&mFrame);
+				sws_freeContext(mScaler);
+				avcodec_free_context(&mCodec);
+				avformat_free_context(mFormat);
+			}
+
+			bool Open() {
+				const std::string path = mSettings.path.string();
+
+				int ret = avformat_alloc_output_context2(&mFormat, nullptr, nullptr, path.c_str());
+				if (ret < 0 || !mFormat) {
+					spdlog::error("Cannot determine the container of {}: {}", path, Describe_Error(ret));
+					return false;
+				}
+
+				const AVCodec* codec = avcodec_find_encoder(mFormat->oformat->video_codec);
+				if (!codec) {
+					spdlog::error("No video encoder is available for {}", path);
+					return false;
+				}
+
+				mStream = avformat_new_stream(mFormat, nullptr);
+				mCodec = avcodec_alloc_context3(codec);
+				mFrame = av_frame_alloc();
+				mPacket = av_packet_alloc();
+				if (!mStream || !mCodec || !mFrame || !mPacket) {
+					return false;
+				}
+
+				mCodec->width = mSettings.width;
+				mCodec->height = mSettings.height;
+				mCodec->time_base = AVRational{ 1, mSettings.fps };
+				mCodec->framerate = AVRational{ mSettings.fps, 1 };
+				mCodec->pix_fmt = AV_PIX_FMT_YUV420P;
+				// let the codec use all the cores; it runs alongside the render workers, that wait for it anyway
+				mCodec->thread_count = 0;
+
+				if (mFormat->oformat->flags & AVFMT_GLOBALHEADER) {
+					mCodec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+				}
+
+				ret = avcodec_open2(mCodec, codec, nullptr);
+				if (ret < 0) {
+					spdlog::error("Cannot open video encoder {}: {}", codec->name, Describe_Error(ret));
+					return false;
+				}
+
+				ret = avcodec_parameters_from_context(mStream->codecpar, mCodec);
+				if (ret < 0) {
+					return false;
+				}
+				mStream->time_base = mCodec->time_base;
+
+				mFrame->format = mCodec->pix_fmt;
+				mFrame->width = mCodec->width;
+				mFrame->height = mCodec->height;
+				if (av_frame_get_buffer(mFrame, 0) < 0) {
+					return false;
+				}
+
+				mScaler = sws_getContext(mSettings.width, mSettings.height, AV_PIX_FMT_BGRA, mCodec->width, mCodec->height, mCodec->pix_fmt, SWS_BILINEAR, nullptr, nullptr, nullptr);
+				if (!mScaler) {
+					return false;
+				}
+
+				if (!(mFormat->oformat->flags & AVFMT_NOFILE)) {
+					ret = avio_open(&mFormat->pb, path.c_str(), AVIO_FLAG_WRITE);
+					if (ret < 0) {
+						spdlog::error("Cannot create video {}: {}", path, Describe_Error(ret));
+						return false;
+					}
+				}
+
+				ret = avformat_write_header(mFormat, nullptr);
+				if (ret < 0) {
+					spdlog::error("Cannot write video {}: {}", path, Describe_Error(ret));
+					return false;
+				}
+				mHeader_Written = true;
+
+				spdlog::info("Encoding the video in-process with {}", codec->name);
+
+				return true;
+			}
+
+			bool Encode(size_t frameIndex, const BLImage& image, size_t repeat) override {
+
+				BLImageData data;
+				if (image.getData(&data) != BL_SUCCESS) {
+					spdlog::error("Cannot access pixel data of frame {}", frameIndex);
+					return false;
+				}
+
+				// the encoder may still reference the previous frame
+				if (av_frame_make_writable(mFrame) < 0) {
+					return false;
+				}
+
+				{
+					CProfile_Scope scope("encode", "Convert frame");
+
+					// PRGB32 is stored as BGRA in memory; the frames are opaque, so premultiplication does not matter
+					const uint8_t* srcSlice[1] = { static_cast<const uint8_t*>(data.pixelData) };
+					const int srcStride[1] = { static_cast<int>(data.stride) };
+					sws_scale(mScaler, srcSlice, srcStride, 0, data.size.h, mFrame->data, mFrame->linesize);
+				}
+
+				CProfile_Scope scope("encode", "Encode video frame");
+
+				// repeated frames are converted just once, they differ only in the timestamp
+				for (size_t i = 0; i <= repeat; i++) {
+					mFrame->pts = mNext_Pts++;
+
+					const int ret = avcodec_send_frame(mCodec, mFrame);
+					if (ret < 0) {
+						spdlog::error("Cannot encode frame {}: {}", frameIndex + i, Describe_Error(ret));
+						return false;
+					}
+
+					if (!Drain()) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			bool Finish() override {
+				if (mFinished) {
+					return true;
+				}
+				mFinished = true;
+
+				// flush the frames delayed by the encoder (e.g., for B-frames)
+				const int ret = avcodec_send_frame(mCodec, nullptr);
+				bool ok = (ret >= 0) && Drain();
+
+				if (av_write_trailer(mFormat) < 0) {
+					ok = false;
+				}
+				if (!(mFormat->oformat->flags & AVFMT_NOFILE) && avio_closep(&mFormat->pb) < 0) {
+					ok = false;
+				}
+
+				if (!ok) {
+					spdlog::error("Cannot complete video {}", mSettings.path.string());
+				}
+
+				return ok;
+			}
+	};
+}
+#endif
+
+std::unique_ptr<CVideo_Encoder> CVideo_Encoder::Create(const TVideo_Settings& settings) {
+
+#ifdef VIDGENX_HAVE_LIBAV
+	auto encoder = std::make_unique<CLibav_Video_Encoder>(settings);
+	if (!encoder->Open()) {
+		return nullptr;
+	}
+
+	return encoder;
+#else
+	return nullptr;
+#endif
+}
+
+bool CVideo_Encoder::Is_Available() {
+#ifdef VIDGENX_HAVE_LIBAV
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::optional<NVideo_Backend> CVideo_Encoder::Parse_Backend(std::string_view name) {
+
+	if (name == "auto") {
+		return NVideo_Backend::Auto;
+	}
+	if (name == "libav") {
+		return NVideo_Backend::Libav;
+	}
+	if (name == "ffmpeg") {
+		return NVideo_Backend::FFMPEG;
+	}
+
+	return std::nullopt;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include <blend2d.h>
+
+/*
+ * Encoder of the streamed video
+ */
+enum class NVideo_Backend {
+	Auto,		// in-process libav encoder if available, the ffmpeg binary otherwise
+	Libav,		// libavcodec/libavformat linked into the program
+	FFMPEG,		// ffmpeg binary reading raw frames from its standard input
+};
+
+/*
+ * Video encoder settings
+ */
+struct TVideo_Settings {
+	std::filesystem::path path;		// output video; the container is chosen by its extension
+	int width = 0;					// frame width in pixels
+	int height = 0;					// frame height in pixels
+	int fps = 0;					// frame rate
+};
+
+/*
+ * In-process video encoder - the rendered frames are encoded and muxed into the output video as they come, without
+ * spawning ffmpeg and without any intermediate files
+ */
+class CVideo_Encoder {
+	public:
+		virtual ~CVideo_Encoder() = default;
+
+		// creates an encoder writing given video; nullptr if the program was built without libav, or the encoder cannot be opened
+		static std::unique_ptr<CVideo_Encoder> Create(const TVideo_Settings& settings);
+		// was the program built with libav?
+		static bool Is_Available();
+		// parses backend name (as in the configuration)
+		static std::optional<NVideo_Backend> Parse_Backend(std::string_view name);
+
+		// encodes a frame followed by given number of its repetitions; frames must come in order
+		virtual bool Encode(size_t frameIndex, const BLImage& image, size_t repeat) = 0;
+		// flushes the encoder and completes the video file
+		virtual bool Finish() = 0;
+};
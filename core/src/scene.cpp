@@ -1,11 +1,20 @@
 #include "scene.h"
 #include "factory.h"
+#include "render/bounds.h"
+#include "profiler.h"
 
 #include <stdexcept>
+#include <format>
+#include <algorithm>
 #include <iostream>
 
 #include <spdlog/spdlog.h>
 
+namespace {
+	// profiler categories of recording objects (indexed by NObject_Type)
+	constexpr const char* Record_Categories[Object_Type_Count] = { "record.none", "record.rectangle", "record.circle", "record.composite" };
+}
+
 CScene::CScene() {
 	//
 }
@@ -14,14 +23,39 @@ std::unique_ptr<CScene> CScene::Build_From(CBlock* block) {
 
 	std::unique_ptr<CScene> ret = std::make_unique<CScene>();
 
-	for (auto& sc : block->Get_Content()->Get_Subcommands()) {
+	ret->mBlock = block;
+
+	if (!ret->Instantiate_Entities()) {
+		return nullptr;
+	}
+
+	auto* pars = block->Get_Parameters();
+	if (pars) {
+		if (auto* duration = pars->Find_Parameter(Symbols::Duration)) {
+			ret->mMax_Frame = (std::get<int>(duration->value) / 1000) * sConfig.Get_FPS();
+		}
+	}
+
+	return ret;
+}
+
+bool CScene::Instantiate_Entities() {
+
+	mEntities.clear();
+	mScene_Objects.clear();
+	mObject_Counter = 1;
+
+	// the names may still be referenced by snapshots of the previous run, so they are not modified in place
+	mEntity_Names = std::make_shared<std::vector<const char*>>();
+
+	for (auto& sc : mBlock->Get_Content()->Get_Subcommands()) {
 		auto name = sc->Get_Entity_Name();
 
 		auto obj = sFactory.Create(name);
 
 		if (!obj) {
-			spdlog::error("Cannot instantiate an object with name '{}'", name);
-			return nullptr;
+			spdlog::error("Cannot instantiate an object with name '{}'", sSymbols.Get_Name(name));
+			return false;
 		}
 
 		if (sc->Get_Params()) {
@@ -31,59 +65,141 @@ std::unique_ptr<CScene> CScene::Build_From(CBlock* block) {
 			obj->Apply_Attribute_Block(sc->Get_Attributes());
 		}
 
-		if (!sc->Get_Object_Reference().empty()) {
+		if (sc->Get_Object_Reference() != Invalid_Symbol) {
 			obj->Set_Object_Reference(sc->Get_Object_Reference());
 		}
 
-		std::string objId = sc->Get_Identifier();
-		if (objId.empty()) {
-			objId = "object" + std::to_string(ret->mObject_Counter++);
-		}
+		obj->Prepare();
 
-		ret->mEntities.push_back(std::move(obj));
-		ret->mScene_Objects[objId] = ret->mEntities.size() - 1;
-	}
-
-	auto* pars = block->Get_Parameters();
-	if (pars) {
-		auto& mp = pars->Get_Parameters();
+		TSymbol objId = sc->Get_Identifier();
+		if (objId == Invalid_Symbol) {
+			objId = sSymbols.Intern("object" + std::to_string(mObject_Counter++));
+		}
 
-		auto itr = mp.find("duration");
-		if (itr != mp.end()) {
-			ret->mMax_Frame = (std::get<int>(itr->second.value) / 1000) * sConfig.Get_FPS();
+		// animations are named by the object they animate, so it's obvious which one is expensive
+		if (obj->Get_Type() == NEntity_Type::Animate) {
+			mEntity_Names->push_back(sProfiler.Intern_Name(std::format("{}.Animate#{}", sSymbols.Get_Name(obj->Get_Object_Reference().value_or(Invalid_Symbol)), mEntities.size())));
+		}
+		else {
+			// symbol names are never released, so they may be recorded as they are
+			mEntity_Names->push_back(sSymbols.Get_Name(objId).c_str());
 		}
+
+		mEntities.push_back(std::move(obj));
+		mScene_Objects[objId] = mEntities.size() - 1;
 	}
 
-	return ret;
+	return mTimeline.Compile(mEntities, mScene_Objects);
 }
 
-const std::unique_ptr<CScene_Entity>& CScene::Get_Object_By_Name(const std::string& name) {
+const std::unique_ptr<CScene_Entity>& CScene::Get_Object_By_Name(TSymbol name) {
 
 	auto itr = mScene_Objects.find(name);
 
 	if (itr == mScene_Objects.end()) {
-		spdlog::error("Cannot find object with name '{}'", name);
+		spdlog::error("Cannot find object with name '{}'", sSymbols.Get_Name(name));
 		throw std::invalid_argument{ "No object with name" };
 	}
 
 	return mEntities[itr->second];
 }
 
-void CScene::Begin() {
+bool CScene::Begin() {
+
+	// animations capture the values they start from, so the entities must start over from their initial state
+	if (mStarted && !Instantiate_Entities()) {
+		return false;
+	}
+
+	mStarted = true;
 	mCurrent_Entity = 0;
+	mFrame_Counter = 0;
+	mWorking_Objects.clear();
+	mWorking_Animations.clear();
+	Reset_Render_State();
 	Update_Scene();
+
+	return true;
+}
+
+void CScene::Reset_Render_State() {
+	mStatic_Layer_Objects.clear();
+	mStatic_Layer.reset();
+	mObject_Bounds.clear();
+	mFull_Damage = true;
+	mEntities_Entered = true;
+	mChanged_Last_Frame = true;
+	mAnimations_Changed = false;
+}
+
+bool CScene::Seek(size_t frame) {
+
+	if (frame >= Get_Frame_Count()) {
+		spdlog::error("Cannot seek to frame {}, the scene has only {} frames", frame, Get_Frame_Count());
+		return false;
+	}
+
+	if (!Begin()) {
+		return false;
+	}
+
+	// it's enough to visit the frames, in which some entities enter the scene; animations only depend on the frame,
+	// so applying them in the frame before gives the same values a full playback would
+	while (mCurrent_Entity < mEntities.size() && mTimeline.Get_Entry(mCurrent_Entity).start <= frame) {
+
+		const size_t enterFrame = mTimeline.Get_Entry(mCurrent_Entity).start;
+
+		mFrame_Counter = enterFrame - 1;
+		Apply_Animations();
+
+		mFrame_Counter = enterFrame;
+		Update_Scene();
+	}
+
+	// objects drawn before their animation see the values from the previous frame
+	if (mFrame_Counter < frame) {
+		mFrame_Counter = frame - 1;
+		Apply_Animations();
+
+		mFrame_Counter = frame;
+	}
+
+	mAnimations_Changed = false;
+
+	return true;
+}
+
+bool CScene::Apply_Animations() {
+	bool changed = false;
+
+	for (auto& anim : mWorking_Animations) {
+		changed |= mTimeline.Apply(anim.entity, mFrame_Counter);
+	}
+
+	return changed;
 }
 
 void CScene::Update_Scene() {
 
-	for (; mCurrent_Entity < mEntities.size(); mCurrent_Entity++) {
+	CProfile_Scope scope("scene", "Update_Scene");
 
-		if (mEntities[mCurrent_Entity]->Execute(*this) == NExecution_Result::Suspend) {
-			break;
-		}
+	// the start frames are known from the timeline, so just let in the entities, whose time has come
+	for (; mCurrent_Entity < mEntities.size() && mTimeline.Get_Entry(mCurrent_Entity).start <= mFrame_Counter; mCurrent_Entity++) {
 
-		if (mEntities[mCurrent_Entity]->Get_Type() == NEntity_Type::Object || mEntities[mCurrent_Entity]->Get_Type() == NEntity_Type::Animate) {
-			mWorking_Entites.push_back(mCurrent_Entity);
+		const auto type = mTimeline.Get_Entry(mCurrent_Entity).type;
+
+		if (type == NEntity_Type::Animate) {
+			// the animation starts from whatever values the parameters have right now
+			mTimeline.Capture(mCurrent_Entity);
+			mAnimations_Changed |= mTimeline.Apply(mCurrent_Entity, mFrame_Counter);
+
+			mWorking_Animations.push_back({ mCurrent_Entity, mWorking_Objects.size() });
+			mEntities_Entered = true;
+		}
+		else if (type == NEntity_Type::Object) {
+			// entities of the object type are always scene objects, so the type tag is enough to downcast
+			mWorking_Objects.push_back({ mCurrent_Entity, static_cast<const CScene_Object*>(mEntities[mCurrent_Entity].get()) });
+			mEntities_Entered = true;
 		}
 	}
 }
@@ -100,20 +216,135 @@ bool CScene::Next_Frame() {
 	return true;
 }
 
-void CScene::Render_Frame(BLContext& context) {
+std::set<size_t> CScene::Collect_Animated_Objects() const {
+
+	std::set<size_t> animated;
+
+	for (auto& anim : mWorking_Animations) {
+		if (mTimeline.Is_Running(anim.entity, mFrame_Counter)) {
+			animated.insert(mTimeline.Get_Entry(anim.entity).target.value());
+		}
+	}
+
+	return animated;
+}
+
+void CScene::Render_Frame(CFrame_Snapshot& snapshot) {
+
+	CProfile_Scope scope("scene", "Render_Frame");
+
+	auto animated = Collect_Animated_Objects();
+
+	// objects below the first animated one in the drawing order do not change, so they may be cached in a static layer;
+	// objects above it must be drawn every frame, otherwise they would end up below the animated object
+	std::vector<size_t> staticObjects;
+	for (auto& drawable : mWorking_Objects) {
+		if (animated.contains(drawable.entity)) {
+			break;
+		}
+		staticObjects.push_back(drawable.entity);
+	}
+
+	// an object entered the scene, started or stopped animating - the layer has to be built again
+	const bool rebuildLayer = (staticObjects != mStatic_Layer_Objects);
+
+	CFrame_Snapshot layerSnapshot(snapshot.Get_Frame_Index());
+	size_t staticRemaining = staticObjects.size();
+
+	// the area, that changed since the previous frame
+	CDamage_Region damage(static_cast<int>(sConfig.Get_Width()), static_cast<int>(sConfig.Get_Height()));
+	if (mFull_Damage) {
+		damage.Set_Full();
+		mFull_Damage = false;
+	}
+
+	bool changedNow = mAnimations_Changed;
+	mAnimations_Changed = false;
+
+	// animations are applied in the scene order, so objects preceding an animation see its values from the previous frame
+	auto nextAnim = mWorking_Animations.begin();
+	auto applyAnimations = [&](size_t objectsDrawn) {
+		for (; nextAnim != mWorking_Animations.end() && nextAnim->objectsBefore <= objectsDrawn; ++nextAnim) {
+			CProfile_Scope animScope("animate", (*mEntity_Names)[nextAnim->entity]);
+			changedNow |= mTimeline.Apply(nextAnim->entity, mFrame_Counter);
+		}
+	};
+
+	for (size_t i = 0; i < mWorking_Objects.size(); i++) {
+
+		applyAnimations(i);
+
+		const size_t idx = mWorking_Objects[i].entity;
+		const CScene_Object& obj = *mWorking_Objects[i].object;
+
+		CProfile_Scope objScope(Record_Categories[static_cast<size_t>(obj.Get_Object_Type())], (*mEntity_Names)[idx]);
+
+		if (staticRemaining > 0) {
+			staticRemaining--;
+			if (rebuildLayer) {
+				layerSnapshot.Set_Owner(idx);
+				Visit_Object(obj, [&](auto& object) { return object.Render(layerSnapshot, CTransform::Identity()); });
+			}
+		}
+		else {
+			snapshot.Set_Owner(idx);
+			Visit_Object(obj, [&](auto& object) { return object.Render(snapshot, CTransform::Identity()); });
+		}
+
+		// only new and animated objects may change; the changed area is where the object was, and where it is now
+		auto bitr = mObject_Bounds.find(idx);
+		if (bitr == mObject_Bounds.end() || animated.contains(idx)) {
+			const BLBox bounds = Visit_Object(obj, [](auto& object) { return object.Get_Bounding_Box(CTransform::Identity()); });
+
+			if (bitr != mObject_Bounds.end()) {
+				damage.Add(bitr->second);
+			}
+			damage.Add(bounds);
 
-	for (size_t idx : mWorking_Entites) {
+			mObject_Bounds[idx] = bounds;
+		}
+	}
+
+	applyAnimations(mWorking_Objects.size());
+
+	snapshot.Set_Damage(damage);
 
-		mEntities[idx]->Execute(*this);
+	// objects drawn before an animation pick up its changes one frame later, so the previous frame counts as well
+	mFrame_Changed = mEntities_Entered || changedNow || mChanged_Last_Frame;
+	mChanged_Last_Frame = changedNow;
+	mEntities_Entered = false;
 
-		auto* obj = dynamic_cast<CScene_Object*>(mEntities[idx].get());
-		if (obj) {
-			obj->Render(context, CTransform::Identity());
+	if (rebuildLayer) {
+		mStatic_Layer_Objects = std::move(staticObjects);
+
+		if (mStatic_Layer_Objects.empty()) {
+			mStatic_Layer.reset();
+		}
+		else {
+			mStatic_Layer = std::make_shared<const CStatic_Layer>(static_cast<int>(sConfig.Get_Width()), static_cast<int>(sConfig.Get_Height()), layerSnapshot.Take_Primitives());
+			spdlog::debug("Static layer rebuilt at frame {} with {} objects", mFrame_Counter, mStatic_Layer_Objects.size());
 		}
 	}
 
+	snapshot.Set_Static_Layer(mStatic_Layer);
+	snapshot.Set_Owner_Names(mEntity_Names);
 }
 
 size_t CScene::Get_Current_Frame() const {
 	return mFrame_Counter;
 }
+
+size_t CScene::Get_Frame_Count() const {
+	// the first frame is always rendered, even if the scene has no duration
+	return std::max(mMax_Frame, static_cast<size_t>(1));
+}
+
+bool CScene::Is_Frame_Changed() const {
+	return mFrame_Changed;
+}
+
+void CScene::Account_Storage(TStorage_Usage& usage) const {
+	for (auto& entity : mEntities) {
+		entity->Account_Storage(usage);
+	}
+}
@@ -3,11 +3,31 @@
 #include "config.h"
 #include "parser_entities.h"
 #include "objects.h"
+#include "render/frame_snapshot.h"
+#include "render/static_layer.h"
+#include "timeline.h"
 
 #include <memory>
 #include <map>
+#include <set>
 #include <blend2d.h>
 
+/*
+ * Drawable object present on the screen
+ */
+struct TScene_Drawable {
+	size_t entity = 0;							// index of the object in scene entities
+	const CScene_Object* object = nullptr;		// the object itself
+};
+
+/*
+ * Animation present on the screen
+ */
+struct TScene_Controller {
+	size_t entity = 0;							// index of the animation in scene entities
+	size_t objectsBefore = 0;					// number of drawables, that precede the animation in the scene (and are drawn before it applies)
+};
+
 /*
  * Scene instance class
  */
@@ -21,13 +41,53 @@ class CScene {
 		size_t mObject_Counter = 1;
 		// maximum frame to which the scene should be rendered
 		size_t mMax_Frame = 0;
+		// block the scene was built from; entities are instantiated from it again when seeking
+		CBlock* mBlock = nullptr;
+		// were the entities touched by rendering (so they no longer hold their initial state)?
+		bool mStarted = false;
 
 		// scene entities (loaded and instantiated from the beginning)
 		std::vector<std::unique_ptr<CScene_Entity>> mEntities;
 		// scene objects reference - references the index in mEntities
-		std::map<std::string, size_t> mScene_Objects;
-		// entities currently present on the screen
-		std::vector<size_t> mWorking_Entites;
+		std::map<TSymbol, size_t> mScene_Objects;
+		// names of entities (indexed the same way as mEntities), used to attribute the work to entities when profiling; the names
+		// are interned, so they outlive the scene
+		std::shared_ptr<std::vector<const char*>> mEntity_Names;
+		// drawable objects currently present on the screen, in the drawing order
+		std::vector<TScene_Drawable> mWorking_Objects;
+		// animations currently present on the screen, in the scene order
+		std::vector<TScene_Controller> mWorking_Animations;
+		// start frames and animation tracks of entities, compiled when the entities are instantiated
+		CScene_Timeline mTimeline;
+
+		// objects (indices to mEntities) cached in the static layer
+		std::vector<size_t> mStatic_Layer_Objects;
+		// pre-rasterized static objects at the bottom of the drawing order
+		std::shared_ptr<const CStatic_Layer> mStatic_Layer;
+
+		// bounding boxes of objects as they were drawn last time (indexed by mEntities index)
+		std::map<size_t, BLBox> mObject_Bounds;
+		// should the next frame be redrawn completely?
+		bool mFull_Damage = true;
+
+		// did an entity enter the scene since the last recorded frame?
+		bool mEntities_Entered = true;
+		// did an animation change a parameter while recording the previous frame?
+		bool mChanged_Last_Frame = true;
+		// does the last recorded frame differ from the one before it?
+		bool mFrame_Changed = true;
+		// did an animation entering the scene change a parameter since the last recorded frame?
+		bool mAnimations_Changed = false;
+
+	protected:
+		// instantiates all scene entities from the scene block (again) and compiles their timeline
+		bool Instantiate_Entities();
+		// resets the rendering state, so the next recorded frame is drawn from scratch
+		void Reset_Render_State();
+		// sets all parameters animated by animations present on the screen to their values in current frame; returns true, if any changed
+		bool Apply_Animations();
+		// collects objects, that are changed by a running animation in current frame
+		std::set<size_t> Collect_Animated_Objects() const;
 
 	public:
 		CScene();
@@ -36,16 +96,25 @@ class CScene {
 		static std::unique_ptr<CScene> Build_From(CBlock* block);
 
 		// retrieves an object pointer by its name
-		const std::unique_ptr<CScene_Entity>& Get_Object_By_Name(const std::string& name);
+		const std::unique_ptr<CScene_Entity>& Get_Object_By_Name(TSymbol name);
 
-		// begins the scene rendering
-		void Begin();
+		// begins the scene rendering; when the scene was rendered before, it starts over from its initial state
+		bool Begin();
+		// puts the scene directly into the state of given frame, as if it was rendered from the beginning; then the scene
+		// continues with Render_Frame and Next_Frame as usual
+		bool Seek(size_t frame);
 		// updates scene according to current frame
 		void Update_Scene();
 		// moves to next frame, updates the scene accordingly
 		bool Next_Frame();
-		// renders the current frame to given context
-		void Render_Frame(BLContext& context);
+		// records the current frame into given snapshot; all parameters are resolved here, so the snapshot may be rasterized on any thread
+		void Render_Frame(CFrame_Snapshot& snapshot);
 		// retrieves current frame index
 		size_t Get_Current_Frame() const;
+		// retrieves the number of frames the scene renders to; known right after the scene is built
+		size_t Get_Frame_Count() const;
+		// does the last recorded frame differ from the previous one? if not, the previous frame may be reused
+		bool Is_Frame_Changed() const;
+		// adds the storage of all scene entities to given usage
+		void Account_Storage(TStorage_Usage& usage) const;
 };
@@ -0,0 +1,48 @@
+#include "symbols.h"
+
+#include <algorithm>
+#include <cctype>
+
+CSymbol_Table::CSymbol_Table() {
+	// the invalid symbol has an empty name
+	mNames.emplace_back();
+
+	for (TSymbol i = 1; i < Symbols::count; i++) {
+		Intern(Builtin_Symbol_Names[i]);
+	}
+}
+
+TSymbol CSymbol_Table::Intern(std::string_view name) {
+	std::unique_lock lck(mMutex);
+
+	auto itr = mSymbols.find(name);
+	if (itr != mSymbols.end()) {
+		return itr->second;
+	}
+
+	const TSymbol symbol = static_cast<TSymbol>(mNames.size());
+	mNames.emplace_back(name);
+	mSymbols.emplace(mNames.back(), symbol);
+
+	return symbol;
+}
+
+TSymbol CSymbol_Table::Find(std::string_view name) const {
+	std::unique_lock lck(mMutex);
+
+	auto itr = mSymbols.find(name);
+	return (itr != mSymbols.end()) ? itr->second : Invalid_Symbol;
+}
+
+const std::string& CSymbol_Table::Get_Name(TSymbol symbol) const {
+	std::unique_lock lck(mMutex);
+
+	return (symbol < mNames.size()) ? mNames[symbol] : mNames.front();
+}
+
+TSymbol CSymbol_Table::Intern_Folded(std::string_view name) {
+	std::string folded(name);
+	std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	return Intern(folded);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+// interned symbol identifier
+using TSymbol = uint32_t;
+
+// symbol identifier, that does not belong to any name
+constexpr TSymbol Invalid_Symbol = 0;
+
+/*
+ * Built-in symbols - names the code looks up directly; they are interned first, so their identifiers are known at compile time
+ */
+namespace Symbols {
+	constexpr TSymbol X = 1;
+	constexpr TSymbol Y = 2;
+	constexpr TSymbol Rotate = 3;
+	constexpr TSymbol Scale = 4;
+	constexpr TSymbol Width = 5;
+	constexpr TSymbol Height = 6;
+	constexpr TSymbol R = 7;
+	constexpr TSymbol Fill = 8;
+	constexpr TSymbol Stroke = 9;
+	constexpr TSymbol Stroke_Width = 10;
+	constexpr TSymbol Duration = 11;
+	constexpr TSymbol FPS = 12;
+	constexpr TSymbol Default_Background = 13;
+	constexpr TSymbol Rectangle = 14;
+	constexpr TSymbol Circle = 15;
+	constexpr TSymbol Composite = 16;
+	constexpr TSymbol Wait = 17;
+	constexpr TSymbol Animate = 18;
+
+	constexpr TSymbol count = 19;
+}
+
+// names of built-in symbols (indexed by symbol identifier); all names are case-folded, as the lexer folds identifiers
+constexpr const char* Builtin_Symbol_Names[Symbols::count] = {
+	"", "x", "y", "rotate", "scale", "width", "height", "r", "fill", "stroke", "strokewidth", "duration",
+	"fps", "defaultbackground", "rectangle", "circle", "composite", "wait", "animate"
+};
+
+/*
+ * Symbol table - interns names (identifiers, parameter and attribute names), so they may be compared and looked up
+ * as plain integers instead of strings
+ *
+ * Symbols are never released; the table outlives all inputs, so the identifiers stay valid across rebuilds
+ */
+class CSymbol_Table {
+	private:
+		// transparent hash, so the table may be searched with string views
+		struct TString_Hash {
+			using is_transparent = void;
+			size_t operator()(std::string_view str) const {
+				return std::hash<std::string_view>{}(str);
+			}
+		};
+
+		// guards the table; symbols are usually interned while parsing, but lookups may come from any thread
+		mutable std::mutex mMutex;
+		// symbol identifiers of interned names
+		std::unordered_map<std::string, TSymbol, TString_Hash, std::equal_to<>> mSymbols;
+		// interned names indexed by symbol identifier; deque keeps references valid when growing
+		std::deque<std::string> mNames;
+
+		// private singleton constructor to avoid multiple instantiation
+		CSymbol_Table();
+
+	public:
+		// static singleton retrieval method
+		static CSymbol_Table& Instance() {
+			static CSymbol_Table gInstance;
+			return gInstance;
+		}
+
+		// retrieves the symbol of given name, interns the name if needed
+		TSymbol Intern(std::string_view name);
+		// retrieves the symbol of given name, or Invalid_Symbol if the name was never interned
+		TSymbol Find(std::string_view name) const;
+		// retrieves the name of given symbol
+		const std::string& Get_Name(TSymbol symbol) const;
+		// case-folds the name and retrieves its symbol, interns the name if needed
+		TSymbol Intern_Folded(std::string_view name);
+};
+
+#define sSymbols CSymbol_Table::Instance()
@@ -0,0 +1,108 @@
+#include "timeline.h"
+
+#include <spdlog/spdlog.h>
+
+std::unique_ptr<CAnimation_Track> CScene_Timeline::Create_Track(CGeneric_Param_Wrapper* param, const TValue_Spec& target) {
+
+	// the parameter is animated only if the target value has the same type as the parameter itself
+	return std::visit([param](auto&& tval) -> std::unique_ptr<CAnimation_Track> {
+		using TVal = std::remove_cvref_t<decltype(tval)>;
+
+		auto* typed = dynamic_cast<CParam_Wrapper<TVal>*>(param);
+		if (!typed) {
+			return nullptr;
+		}
+
+		return std::make_unique<CTyped_Track<TVal>>(typed, tval);
+	}, target.value);
+}
+
+bool CScene_Timeline::Compile(const std::vector<std::unique_ptr<CScene_Entity>>& entities, const std::map<TSymbol, size_t>& sceneObjects) {
+
+	mEntries.clear();
+	mTracks.clear();
+
+	// entities enter the scene all at once, until there is a wait; the following entities enter one frame after the wait elapses
+	size_t frame = 0;
+
+	for (auto& ent : entities) {
+		TTimeline_Entry entry;
+		entry.type = ent->Get_Type();
+		entry.start = frame;
+
+		if (entry.type == NEntity_Type::Wait) {
+			entry.duration = static_cast<const CEntity_Wait*>(ent.get())->Get_Duration_Frames();
+			frame += entry.duration + 1;
+		}
+		else if (entry.type == NEntity_Type::Animate) {
+			auto* anim = static_cast<CEntity_Animate*>(ent.get());
+			entry.duration = anim->Get_Duration_Frames();
+
+			auto& ref = anim->Get_Object_Reference();
+			auto oitr = ref.has_value() ? sceneObjects.find(ref.value()) : sceneObjects.end();
+			if (oitr == sceneObjects.end()) {
+				spdlog::error("Cannot find object with name '{}'", sSymbols.Get_Name(ref.value_or(Invalid_Symbol)));
+				return false;
+			}
+
+			entry.target = oitr->second;
+			entry.firstTrack = mTracks.size();
+
+			for (auto& ap : anim->Get_Animation_Params()) {
+				auto* param = entities[oitr->second]->Get_Param_Ref(ap.paramName);
+				if (!param) {
+					continue;
+				}
+
+				auto track = Create_Track(param, ap.target);
+				if (track) {
+					mTracks.push_back(std::move(track));
+				}
+			}
+
+			entry.trackCount = mTracks.size() - entry.firstTrack;
+		}
+
+		mEntries.push_back(entry);
+	}
+
+	return true;
+}
+
+const TTimeline_Entry& CScene_Timeline::Get_Entry(size_t entity) const {
+	return mEntries[entity];
+}
+
+void CScene_Timeline::Capture(size_t entity) {
+	auto& entry = mEntries[entity];
+
+	for (size_t i = entry.firstTrack; i < entry.firstTrack + entry.trackCount; i++) {
+		mTracks[i]->Capture();
+	}
+}
+
+bool CScene_Timeline::Apply(size_t entity, size_t frame) {
+	auto& entry = mEntries[entity];
+
+	const size_t frameDiff = frame - entry.start;
+
+	double progress = 0;
+	if (entry.duration < frameDiff)
+		progress = 1;
+	else
+		progress = static_cast<double>(frameDiff) / static_cast<double>(entry.duration);
+
+	bool changed = false;
+	for (size_t i = entry.firstTrack; i < entry.firstTrack + entry.trackCount; i++) {
+		changed |= mTracks[i]->Apply(progress);
+	}
+
+	return changed;
+}
+
+bool CScene_Timeline::Is_Running(size_t entity, size_t frame) const {
+	auto& entry = mEntries[entity];
+
+	// objects preceding the animation in the scene pick up the new values one frame later, hence the extra frame
+	return entry.type == NEntity_Type::Animate && frame <= entry.start + entry.duration + 1;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "objects.h"
+#include "entities/builtin_animatons.h"
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <string>
+
+/*
+ * A single animated parameter with its interpolation resolved at build time
+ */
+class CAnimation_Track {
+	public:
+		virtual ~CAnimation_Track() = default;
+
+		// captures the current value of the parameter as the animation start value
+		virtual void Capture() = 0;
+		// sets the parameter to the interpolated value; returns true, if the value changed
+		virtual bool Apply(double progress) = 0;
+};
+
+/*
+ * Animation track of a parameter of given type
+ */
+template<typename T>
+class CTyped_Track : public CAnimation_Track {
+	private:
+		// animated parameter
+		CParam_Wrapper<T>* mParam;
+		// value of the parameter when the animation started
+		T mInitial{};
+		// target value of the parameter
+		T mTarget;
+
+	public:
+		CTyped_Track(CParam_Wrapper<T>* param, const T& target) : mParam(param), mTarget(target) {}
+
+		void Capture() override {
+			mInitial = mParam->Get_Typed_Value();
+		}
+
+		bool Apply(double progress) override {
+			return mParam->Set_Typed_Value(Animate_Linear(mInitial, mTarget, progress));
+		}
+};
+
+/*
+ * Timeline entry of a single scene entity
+ */
+struct TTimeline_Entry {
+	NEntity_Type type = NEntity_Type::Object;	// type of the entity
+	size_t start = 0;							// frame, in which the entity enters the scene
+	size_t duration = 0;						// duration of a wait or an animation in frames
+	size_t firstTrack = 0;						// index of the first animation track of the entity
+	size_t trackCount = 0;						// number of animation tracks of the entity
+	std::optional<size_t> target;				// animated object (index of the entity)
+};
+
+/*
+ * Compiled scene timeline - start frames of all entities and typed animation tracks, so the frames can be
+ * played without looking up objects or parameters by name
+ */
+class CScene_Timeline {
+	private:
+		// entries in the order of scene entities
+		std::vector<TTimeline_Entry> mEntries;
+		// animation tracks of all animations
+		std::vector<std::unique_ptr<CAnimation_Track>> mTracks;
+
+	protected:
+		// creates a track animating given parameter; returns nullptr if the target value type does not match the parameter
+		static std::unique_ptr<CAnimation_Track> Create_Track(CGeneric_Param_Wrapper* param, const TValue_Spec& target);
+
+	public:
+		// compiles the timeline of given scene entities; the tracks point to the entity parameters, so the entities must outlive the timeline
+		bool Compile(const std::vector<std::unique_ptr<CScene_Entity>>& entities, const std::map<TSymbol, size_t>& sceneObjects);
+
+		// retrieves the timeline entry of given entity
+		const TTimeline_Entry& Get_Entry(size_t entity) const;
+
+		// captures the start values of animation tracks of given entity
+		void Capture(size_t entity);
+		// sets all parameters animated by given entity to their values in given frame; returns true, if any of them changed
+		bool Apply(size_t entity, size_t frame);
+		// may the animation entity still change the animated object in given frame?
+		bool Is_Running(size_t entity, size_t frame) const;
+};
@@ -1,54 +1,43 @@
 %code requires {
-   class CBlock;
-   class CParams;
-   class CCommand;
-   class CAttributes;
-   struct TParam_Entry;
-   struct TValue_Spec;
-   enum class NBlock_Type;
+   #include "symbols.h"
+   #include "parser_entities.h"
+
+   class CParse_Tree;
 }
 
 %code top {
     #include <iostream>
-    #include <string>
-    #include <list>
-    #include <iostream>
-    #include <string>
-    #include <sstream>
-    #include <iomanip>
+    #include <string_view>
+    #include <charconv>
     #include <bit>
     #include "parser_entities.h"
+    #include "parse_tree.h"
 
     extern int yylex(void);
     extern char* yytext;
 
-    static void yyerror(const char* s) {
-        std::cerr << s << std::endl;
+    static void yyerror(CParse_Tree& tree, const char* s) {
+        tree.Report_Error(s);
     }
 
-    rgb_t hexColorToARGB(const std::string& hexColor) {
-        std::string color = hexColor;
-        if (color[0] == '#')
-            color.erase(0, 1);
+    rgb_t hexColorToARGB(std::string_view hexColor) {
+        if (!hexColor.empty() && hexColor[0] == '#')
+            hexColor.remove_prefix(1);
 
-        std::stringstream ss;
-        ss << std::hex << color;
-        rgb_t argb;
-        ss >> argb;
+        rgb_t argb = 0;
+        std::from_chars(hexColor.data(), hexColor.data() + hexColor.size(), argb, 16);
 
         argb |= 0xFF000000;
 
         return std::bit_cast<rgb_t>(argb);
     }
-
-    std::vector<CBlock*> _Blocks;
-    size_t _Block_Counter = 0;
 }
 
 %union {
     int intval;
     double floatval;
-    char *strval;
+    TSource_Text strval;
+    TSymbol symval;
     CBlock *block;
     NBlock_Type block_type;
     CParams* params;
@@ -58,13 +47,15 @@
     CAttributes* attrs;
 }
 
+%parse-param { CParse_Tree& tree }
 %define parse.error verbose
 %verbose
 
 %token IDENT_CONFIG IDENT_PROTO IDENT_CONSTANTS IDENT_SCENE L_BRACKET R_BRACKET SEMICOLON L_ARROW COMMA L_PAREN R_PAREN DASH EQUALS COLON DOT
 %token<floatval> INT_NUMBER FLOAT_NUMBER
 %token<intval> RGBSPEC TIMESPEC
-%token<strval> STRVALUE IDENTIFIER
+%token<strval> STRVALUE
+%token<symval> IDENTIFIER
 %type<block> top_level_block
 %type<block_type> top_level_identifier
 %type<params> top_level_params
@@ -83,18 +74,16 @@ start
 
 top_level_block_chain
     : top_level_block {
-        $1->Set_Block_Index(_Block_Counter++);
-        _Blocks.push_back($1);
+        tree.Add_Block($1);
     }
     | top_level_block top_level_block_chain {
-        $1->Set_Block_Index(_Block_Counter++);
-        _Blocks.push_back($1);
+        tree.Add_Block($1);
     }
 ;
 
 top_level_block
     : top_level_identifier top_level_params top_level_body {
-        $$ = new CBlock($1);
+        $$ = tree.Create<CBlock>($1);
         $$->Set_Params($2);
         $$->Set_Command($3);
     }
@@ -120,76 +109,75 @@ top_level_params
         $$ = $2;
     }
     | L_PAREN R_PAREN {
-        $$ = new CParams();
+        $$ = tree.Create<CParams>(tree.Get_Arena());
     }
     | {
-        $$ = new CParams();
+        $$ = tree.Create<CParams>(tree.Get_Arena());
     }
 ;
 
 params_block
     : param_spec {
-        $$ = new CParams();
-        $$->Add_Parameter($1);
-        delete $1;
+        $$ = tree.Create<CParams>(tree.Get_Arena());
+        $$->Add_Parameter(*$1);
     }
     | param_spec COMMA params_block {
-        $3->Add_Parameter($1);
-        delete $1;
+        $3->Add_Parameter(*$1);
         $$ = $3;
     }
 ;
 
 param_spec
     : IDENTIFIER EQUALS value_spec {
-        $$ = new TParam_Entry();
+        $$ = tree.Create<TParam_Entry>();
         $$->key = $1;
         $$->value = *$3;
-        delete $3;
     }
 ;
 
 value_spec
     : INT_NUMBER {
-        $$ = new TValue_Spec{ NValue_Type::Float, $1 };
+        $$ = tree.Create<TValue_Spec>(TValue_Spec{ NValue_Type::Float, $1 });
     }
     | FLOAT_NUMBER {
-        $$ = new TValue_Spec{ NValue_Type::Float, $1 };
+        $$ = tree.Create<TValue_Spec>(TValue_Spec{ NValue_Type::Float, $1 });
     }
     | STRVALUE {
-        $$ = new TValue_Spec{ NValue_Type::String, $1 };
+        // the value is copied to prototypes, constants and draw list keys, that outlive the input; so it must not point into it
+        const TSymbol str = sSymbols.Intern($1.View());
+        $$ = tree.Create<TValue_Spec>(TValue_Spec{ NValue_Type::String, sSymbols.Get_Name(str), str });
     }
     | IDENTIFIER {
-        $$ = new TValue_Spec{ NValue_Type::Identifier, $1 };
+        $$ = tree.Create<TValue_Spec>(TValue_Spec{ NValue_Type::Identifier, sSymbols.Get_Name($1), $1 });
     }
     | RGBSPEC L_PAREN STRVALUE R_PAREN {
-        $$ = new TValue_Spec{ NValue_Type::RGB, hexColorToARGB($3) };
+        $$ = tree.Create<TValue_Spec>(TValue_Spec{ NValue_Type::RGB, hexColorToARGB($3.View()) });
     }
     | TIMESPEC {
-        $$ = new TValue_Spec{ NValue_Type::Timespec, $1 };
+        $$ = tree.Create<TValue_Spec>(TValue_Spec{ NValue_Type::Timespec, $1 });
     }
 ;
 
 top_level_body
     : L_BRACKET R_BRACKET {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
     }
     | L_BRACKET command_block R_BRACKET {
         $$ = $2;
     }
     | {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
     }
 ;
 
 command_block
     : command {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Add_Command($1);
     }
-    | command command_block {
-        $$ = $2;
-        $$->Add_Command($1);
+    | command_block command {
+        $$ = $1;
+        $$->Add_Command($2);
     }
 ;
 
@@ -200,48 +188,46 @@ attr_block
     | attr_spec COMMA attr_block {
         $$ = $3;
         $1->Merge_To($$);
-        delete $1;
     }
 ;
 
 attr_spec
     : IDENTIFIER {
-        $$ = new CAttributes();
+        $$ = tree.Create<CAttributes>(tree.Get_Arena());
         $$->Add_Attribute($1);
     }
 ;
 
 command
     : IDENTIFIER EQUALS IDENTIFIER L_PAREN params_block R_PAREN {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Set_Identifier($1);
         $$->Set_Entity_Name($3);
         $$->Set_Params($5);
     }
     | IDENTIFIER L_PAREN params_block R_PAREN {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Set_Entity_Name($1);
         $$->Set_Params($3);
     }
     | IDENTIFIER L_PAREN R_PAREN {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Set_Entity_Name($1);
     }
     | IDENTIFIER EQUALS value_spec {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Set_Identifier($1);
         $$->Set_Value(*$3);
-        delete $3;
     }
     | IDENTIFIER EQUALS IDENTIFIER L_PAREN attr_block R_PAREN L_BRACKET command_block R_BRACKET {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Set_Identifier($1);
         $$->Set_Entity_Name($3);
         $$->Set_Attributes($5);
         $$->Add_Command($8);
     }
     | IDENTIFIER DOT IDENTIFIER L_PAREN params_block R_PAREN {
-        $$ = new CCommand();
+        $$ = tree.Create<CCommand>(tree.Get_Arena());
         $$->Set_Object_Reference($1);
         $$->Set_Entity_Name($3);
         $$->Set_Params($5);
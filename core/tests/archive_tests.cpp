@@ -0,0 +1,124 @@
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+
+#include "test.h"
+
+#include "render/frame_archive.h"
+
+namespace {
+	bool Write_Test_Archive(const std::filesystem::path& path) {
+
+		const std::string first = "first frame";
+		const std::string second = "second";
+		const std::string last = "last";
+
+		CFrame_Archive_Writer writer;
+		if (!writer.Open(path, { NFrame_Format::QOI, 3, 2, 10, 5 })) {
+			return false;
+		}
+
+		// the frames come in any order; frame 8 is never written
+		return writer.Append(7, 0, reinterpret_cast<const uint8_t*>(second.data()), second.size())
+			&& writer.Append(5, 1, reinterpret_cast<const uint8_t*>(first.data()), first.size())
+			&& writer.Append(9, 0, reinterpret_cast<const uint8_t*>(last.data()), last.size())
+			&& !writer.Append(4, 0, reinterpret_cast<const uint8_t*>(last.data()), last.size())
+			&& writer.Close();
+	}
+
+	std::vector<char> Read_File(const std::filesystem::path& path) {
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	void Write_File(const std::filesystem::path& path, const std::vector<char>& data) {
+		std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	// writes a copy of the archive modified by given function and tries to open it
+	template<typename TFunc>
+	bool Open_Modified(const std::vector<char>& archive, TFunc&& modify) {
+		std::vector<char> data = archive;
+		modify(data);
+
+		const auto path = sTests.Get_Work_Path("damaged.vfa");
+		Write_File(path, data);
+
+		CFrame_Archive_Reader reader;
+		return reader.Open(path);
+	}
+
+	template<typename T>
+	void Put(std::vector<char>& data, size_t offset, T value) {
+		std::memcpy(data.data() + offset, &value, sizeof(value));
+	}
+}
+
+TEST_CASE(Frame_Archive_Round_Trip) {
+
+	const auto path = sTests.Get_Work_Path("round_trip.vfa");
+	REQUIRE(Write_Test_Archive(path));
+
+	CFrame_Archive_Reader reader;
+	REQUIRE(reader.Open(path));
+
+	auto& info = reader.Get_Info();
+	CHECK(info.format == NFrame_Format::QOI);
+	CHECK(info.width == 3);
+	CHECK(info.height == 2);
+	CHECK(info.fps == 10);
+	CHECK(info.firstFrame == 5);
+
+	// frames 5 to 9; the repeated frame shares the data, the missing one is empty
+	REQUIRE(reader.Get_Frame_Count() == 5);
+	CHECK(reader.Get_Frame(0) == "first frame");
+	CHECK(reader.Get_Frame(1) == "first frame");
+	CHECK(reader.Get_Frame(1).data() == reader.Get_Frame(0).data());
+	CHECK(reader.Get_Frame(2) == "second");
+	CHECK(reader.Get_Frame(3).empty());
+	CHECK(reader.Get_Frame(4) == "last");
+	CHECK(reader.Get_Frame(5).empty());
+}
+
+TEST_CASE(Frame_Archive_Rejects_Damaged_Files) {
+
+	const auto path = sTests.Get_Work_Path("valid.vfa");
+	REQUIRE(Write_Test_Archive(path));
+
+	const auto archive = Read_File(path);
+	REQUIRE(archive.size() > sizeof(TArchive_Header) + sizeof(TArchive_Footer));
+
+	const size_t footer = archive.size() - sizeof(TArchive_Footer);
+
+	CHECK(Open_Modified(archive, [](auto&) {}));
+
+	// truncated
+	CHECK(!Open_Modified(archive, [](auto& data) { data.resize(data.size() - 1); }));
+	CHECK(!Open_Modified(archive, [](auto& data) { data.resize(sizeof(TArchive_Header)); }));
+
+	// unknown frame format, empty frames
+	CHECK(!Open_Modified(archive, [](auto& data) { Put<uint32_t>(data, offsetof(TArchive_Header, format), 99); }));
+	CHECK(!Open_Modified(archive, [](auto& data) { Put<uint32_t>(data, offsetof(TArchive_Header, width), 0); }));
+
+	// index outside of the file, overlapping the header, or not matching the frame count
+	CHECK(!Open_Modified(archive, [footer](auto& data) { Put<uint64_t>(data, footer + offsetof(TArchive_Footer, indexOffset), data.size()); }));
+	CHECK(!Open_Modified(archive, [footer](auto& data) { Put<uint64_t>(data, footer + offsetof(TArchive_Footer, indexOffset), 0); }));
+	CHECK(!Open_Modified(archive, [footer](auto& data) { Put<uint64_t>(data, footer + offsetof(TArchive_Footer, frameCount), 1000); }));
+
+	// an entry pointing past the frame data is treated as a missing frame
+	uint64_t indexOffset = 0;
+	std::memcpy(&indexOffset, archive.data() + footer + offsetof(TArchive_Footer, indexOffset), sizeof(indexOffset));
+
+	std::vector<char> data = archive;
+	Put<uint64_t>(data, static_cast<size_t>(indexOffset) + offsetof(TArchive_Entry, size), data.size());
+	Write_File(path, data);
+
+	CFrame_Archive_Reader reader;
+	REQUIRE(reader.Open(path));
+	CHECK(reader.Get_Frame(0).empty());
+	CHECK(reader.Get_Frame(2) == "second");
+}
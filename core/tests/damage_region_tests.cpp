@@ -0,0 +1,100 @@
+#include <cmath>
+
+#include "test.h"
+
+#include "render/damage_region.h"
+
+namespace {
+	bool Is_Box(const BLBoxI& box, int x0, int y0, int x1, int y1) {
+		return box.x0 == x0 && box.y0 == y0 && box.x1 == x1 && box.y1 == y1;
+	}
+}
+
+TEST_CASE(Damage_Region_Merges_Overlapping_Boxes) {
+
+	CDamage_Region damage(100, 100);
+	CHECK(damage.Is_Empty());
+	CHECK(!damage.Is_Full());
+
+	// every box grows by a pixel on each side, so the antialiased edges are redrawn too
+	damage.Add(BLBox(10, 10, 20, 20));
+	REQUIRE(damage.Get_Boxes().size() == 1);
+	CHECK(Is_Box(damage.Get_Boxes()[0], 9, 9, 21, 21));
+
+	damage.Add(BLBox(15.5, 15.5, 25.5, 25.5));
+	REQUIRE(damage.Get_Boxes().size() == 1);
+	CHECK(Is_Box(damage.Get_Boxes()[0], 9, 9, 27, 27));
+
+	damage.Add(BLBox(60, 60, 65, 65));
+	CHECK(damage.Get_Boxes().size() == 2);
+
+	// a box touching both of them joins them all into one
+	damage.Add(BLBox(20, 20, 62, 62));
+	REQUIRE(damage.Get_Boxes().size() == 1);
+	CHECK(Is_Box(damage.Get_Boxes()[0], 9, 9, 66, 66));
+
+	// inverted boxes are ignored, boxes outside the canvas are clipped
+	CDamage_Region clipped(100, 100);
+	clipped.Add(BLBox(30, 30, 20, 20));
+	CHECK(clipped.Is_Empty());
+	clipped.Add(BLBox(-50, 90, 10, 500));
+	REQUIRE(clipped.Get_Boxes().size() == 1);
+	CHECK(Is_Box(clipped.Get_Boxes()[0], 0, 89, 11, 100));
+	clipped.Add(BLBox(200, 200, 300, 300));
+	CHECK(clipped.Get_Boxes().size() == 1);
+
+	// regions merge box by box
+	CDamage_Region merged(100, 100);
+	merged.Add(BLBox(80, 10, 85, 15));
+	merged.Add(damage);
+	CHECK(merged.Get_Boxes().size() == 2);
+	merged.Add(clipped);
+	CHECK(merged.Get_Boxes().size() == 3);
+
+	merged.Clear();
+	CHECK(merged.Is_Empty());
+}
+
+TEST_CASE(Damage_Region_Switches_To_Full_Redraw) {
+
+	// more than a half of the canvas is redrawn completely
+	CDamage_Region damage(100, 100);
+	damage.Add(BLBox(0, 0, 60, 40));
+	CHECK(!damage.Is_Full());
+	damage.Add(BLBox(0, 40, 60, 100));
+	CHECK(damage.Is_Full());
+	CHECK(damage.Get_Boxes().empty());
+	CHECK(!damage.Is_Empty());
+
+	// a full region stays full, until cleared
+	damage.Add(BLBox(10, 10, 20, 20));
+	CHECK(damage.Is_Full());
+	damage.Clear();
+	CHECK(damage.Is_Empty());
+
+	// a box, that cannot be computed, means the whole frame may have changed
+	damage.Add(BLBox(std::nan(""), 0, 10, 10));
+	CHECK(damage.Is_Full());
+
+	CDamage_Region full(100, 100);
+	full.Set_Full();
+	CDamage_Region other(100, 100);
+	other.Add(BLBox(10, 10, 20, 20));
+	other.Add(full);
+	CHECK(other.Is_Full());
+}
+
+TEST_CASE(Damage_Region_Collapses_Many_Boxes) {
+
+	// a row of separate boxes; once there are more of them than the region keeps, they collapse to their bounding box
+	CDamage_Region damage(1000, 1000);
+	for (int i = 0; i < 16; i++) {
+		damage.Add(BLBox(i * 10 + 2, 2, i * 10 + 4, 4));
+	}
+	CHECK(damage.Get_Boxes().size() == 16);
+
+	damage.Add(BLBox(500, 500, 502, 502));
+	REQUIRE(damage.Get_Boxes().size() == 1);
+	CHECK(Is_Box(damage.Get_Boxes()[0], 1, 1, 503, 503));
+	CHECK(!damage.Is_Full());
+}
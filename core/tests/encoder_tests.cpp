@@ -0,0 +1,88 @@
+#include <vector>
+#include <cstring>
+
+#include "test.h"
+
+#include "render/frame_encoder.h"
+
+namespace {
+	// 3x2 opaque frame: a run of two equal pixels, a small and a medium color difference, a large one and a repeated color
+	constexpr uint32_t Test_Pixels[] = {
+		0xFF102030, 0xFF102030, 0xFF112131,
+		0xFFFF0000, 0xFF102030, 0xFF18242C,
+	};
+
+	BLImage Make_Test_Image() {
+		BLImage image(3, 2, BL_FORMAT_PRGB32);
+
+		BLImageData data;
+		if (image.makeMutable(&data) == BL_SUCCESS) {
+			for (int y = 0; y < 2; y++) {
+				std::memcpy(static_cast<uint8_t*>(data.pixelData) + y * data.stride, Test_Pixels + y * 3, 3 * sizeof(uint32_t));
+			}
+		}
+
+		return image;
+	}
+
+	std::vector<uint8_t> Encode(NFrame_Format format) {
+		std::vector<uint8_t> output;
+
+		auto encoder = CFrame_Encoder::Create({ format });
+		if (!encoder || !encoder->Encode(Make_Test_Image(), output)) {
+			output.clear();
+		}
+
+		return output;
+	}
+}
+
+TEST_CASE(QOI_Encoder_Output) {
+
+	const std::vector<uint8_t> expected = {
+		'q', 'o', 'i', 'f', 0, 0, 0, 3, 0, 0, 0, 2, 3, 0,		// header: width, height, RGB, sRGB
+		0xFE, 0x10, 0x20, 0x30,									// QOI_OP_RGB
+		0xC0,													// QOI_OP_RUN of 1
+		0x7F,													// QOI_OP_DIFF +1 +1 +1
+		0xFE, 0xFF, 0x00, 0x00,									// QOI_OP_RGB
+		0x15,													// QOI_OP_INDEX 21
+		0xA4, 0xC0,												// QOI_OP_LUMA dg = +4, dr - dg = +4, db - dg = -8
+		0, 0, 0, 0, 0, 0, 0, 1,									// end marker
+	};
+
+	CHECK(Encode(NFrame_Format::QOI) == expected);
+}
+
+TEST_CASE(PPM_Encoder_Output) {
+
+	std::vector<uint8_t> expected = { 'P', '6', '\n', '3', ' ', '2', '\n', '2', '5', '5', '\n' };
+	expected.insert(expected.end(), {
+		0x10, 0x20, 0x30, 0x10, 0x20, 0x30, 0x11, 0x21, 0x31,
+		0xFF, 0x00, 0x00, 0x10, 0x20, 0x30, 0x18, 0x24, 0x2C,
+	});
+
+	CHECK(Encode(NFrame_Format::PPM) == expected);
+}
+
+TEST_CASE(BMP_Encoder_Output) {
+
+	const std::vector<uint8_t> pixels = {
+		0x30, 0x20, 0x10, 0xFF, 0x30, 0x20, 0x10, 0xFF, 0x31, 0x21, 0x11, 0xFF,
+		0x00, 0x00, 0xFF, 0xFF, 0x30, 0x20, 0x10, 0xFF, 0x2C, 0x24, 0x18, 0xFF,
+	};
+
+	std::vector<uint8_t> expected = {
+		'B', 'M', 78, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0,			// file size, pixel data offset
+		40, 0, 0, 0,											// info header size
+		3, 0, 0, 0, 0xFE, 0xFF, 0xFF, 0xFF,						// width, height (negative, top-down)
+		1, 0, 32, 0,											// planes, bits per pixel
+		0, 0, 0, 0, 24, 0, 0, 0,								// no compression, image size
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,			// resolution and palette
+	};
+	expected.insert(expected.end(), pixels.begin(), pixels.end());
+
+	CHECK(Encode(NFrame_Format::BMP) == expected);
+
+	// the raw frame is the same memory layout without any header
+	CHECK(Encode(NFrame_Format::Raw) == pixels);
+}
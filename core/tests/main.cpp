@@ -0,0 +1,41 @@
+#include <string>
+#include <filesystem>
+
+#include "test.h"
+
+#include <spdlog/spdlog.h>
+
+int main(int argc, char** argv) {
+
+	std::filesystem::path workDir = std::filesystem::temp_directory_path() / "vidgenx_tests";
+	std::string filter;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+
+		if (arg == "--work-dir" && i + 1 < argc) {
+			workDir = argv[++i];
+		}
+		else if (arg.starts_with("-")) {
+			spdlog::error("Usage: {} [--work-dir dir] [case name filter]", argv[0]);
+			return 1;
+		}
+		else {
+			filter = arg;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(workDir, ec);
+	if (ec) {
+		spdlog::error("Cannot create work directory {}: {}", workDir.string(), ec.message());
+		return 1;
+	}
+
+	// the tested code logs every phase, which would bury the failed checks
+	spdlog::set_level(spdlog::level::warn);
+
+	sTests.Set_Work_Directory(workDir);
+
+	return sTests.Run(filter) == 0 ? 0 : 2;
+}
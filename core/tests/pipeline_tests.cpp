@@ -0,0 +1,46 @@
+#include <vector>
+#include <string>
+#include <format>
+#include <fstream>
+#include <iterator>
+
+#include "test.h"
+#include "test_controller.h"
+
+namespace {
+	std::vector<uint8_t> Read_File(const std::filesystem::path& path) {
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	// renders the test input through the pipeline with given options and compares the written frames with a full playback
+	void Check_Pipeline_Frames(const std::string& name, const std::vector<std::string>& options) {
+
+		CTest_Controller ctrl;
+		REQUIRE(ctrl.Load(name, Test_Input, options));
+		REQUIRE(ctrl.Render());
+		REQUIRE(ctrl.Get_Scenes().size() == 1);
+
+		auto& scene = *ctrl.Get_Scenes()[0];
+		CFrame_Renderer renderer;
+
+		REQUIRE(scene.Begin());
+		do {
+			const auto path = ctrl.Get_Output_Directory() / std::format("frame_{:06}.bgra", scene.Get_Current_Frame());
+			CHECK(Read_File(path) == renderer.Render(scene));
+		} while (scene.Next_Frame());
+	}
+}
+
+TEST_CASE(Pipeline_Writes_Played_Frames) {
+	Check_Pipeline_Frames("pipeline", { "--jobs", "4", "--format", "raw" });
+}
+
+TEST_CASE(Incremental_Pipeline_Writes_Played_Frames) {
+
+	// only the damage is redrawn over the frame the buffer held before, so the frames sharing a buffer must be drawn in order,
+	// no matter which worker picks them up; the render is repeated, so a race between the workers has a chance to show up
+	for (int i = 0; i < 5; i++) {
+		Check_Pipeline_Frames("pipeline_incremental", { "--jobs", "8", "--incremental", "--format", "raw" });
+	}
+}
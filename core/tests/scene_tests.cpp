@@ -0,0 +1,92 @@
+#include <vector>
+#include <algorithm>
+
+#include "test.h"
+#include "test_controller.h"
+
+#include "render/frame_snapshot.h"
+
+TEST_CASE(Seek_Renders_Same_Frames) {
+
+	CTest_Controller ctrl;
+	REQUIRE(ctrl.Load("seek", Test_Input));
+	REQUIRE(ctrl.Get_Scenes().size() == 1);
+
+	auto& scene = *ctrl.Get_Scenes()[0];
+	CFrame_Renderer renderer;
+
+	// reference: the whole scene played from the beginning
+	std::vector<std::vector<uint8_t>> frames;
+	REQUIRE(scene.Begin());
+	do {
+		frames.push_back(renderer.Render(scene));
+	} while (scene.Next_Frame());
+
+	REQUIRE(frames.size() == scene.Get_Frame_Count());
+
+	// the frames around the wait and the animation boundaries are the interesting ones; seeking backwards is covered as well
+	const size_t last = frames.size() - 1;
+	for (size_t frame : { size_t{ 25 }, size_t{ 0 }, size_t{ 9 }, size_t{ 10 }, size_t{ 11 }, size_t{ 12 }, size_t{ 20 }, size_t{ 21 }, size_t{ 22 }, size_t{ 31 }, size_t{ 32 }, last }) {
+		REQUIRE(scene.Seek(frame));
+		CHECK(scene.Get_Current_Frame() == frame);
+		CHECK(renderer.Render(scene) == frames[frame]);
+
+		// the playback continues from the seeked frame as if it was never interrupted
+		for (size_t next = frame + 1; next <= std::min(frame + 3, last); next++) {
+			REQUIRE(scene.Next_Frame());
+			CHECK(scene.Get_Current_Frame() == next);
+			CHECK(renderer.Render(scene) == frames[next]);
+		}
+	}
+
+	CHECK(!scene.Seek(frames.size()));
+}
+
+TEST_CASE(Timeline_Follows_Wait_And_Animate) {
+
+	CTest_Controller ctrl;
+	REQUIRE(ctrl.Load("timeline", Test_Input));
+	REQUIRE(ctrl.Get_Scenes().size() == 1);
+
+	auto& scene = *ctrl.Get_Scenes()[0];
+
+	// 4 seconds at 10 fps
+	REQUIRE(scene.Get_Frame_Count() == 40);
+
+	// entities in the scene order: base, dot, wait, moving, and the two animations
+	constexpr size_t movingEntity = 3;
+
+	// width of the moving rectangle in every frame; zero when it's not on the screen
+	std::vector<double> widths;
+
+	REQUIRE(scene.Begin());
+	do {
+		CFrame_Snapshot snapshot(scene.Get_Current_Frame());
+		scene.Render_Frame(snapshot);
+
+		double width = 0;
+		for (auto& prim : snapshot.Take_Primitives()) {
+			if (prim.owner == movingEntity) {
+				width = prim.width;
+			}
+		}
+		widths.push_back(width);
+	} while (scene.Next_Frame());
+
+	REQUIRE(widths.size() == 40);
+
+	// the wait lasts 10 frames, the following entities enter one frame after it elapses
+	for (size_t frame = 0; frame <= 10; frame++) {
+		CHECK(widths[frame] == 0);
+	}
+	CHECK(widths[11] == 20);
+
+	// the animation takes 20 frames; the rectangle is drawn before its animation, so it picks the values up a frame later
+	for (size_t frame = 12; frame < widths.size(); frame++) {
+		CHECK(widths[frame] >= widths[frame - 1]);
+	}
+	CHECK(widths[21] > 20 && widths[21] < 60);
+	for (size_t frame = 33; frame < widths.size(); frame++) {
+		CHECK(widths[frame] == 60);
+	}
+}
@@ -0,0 +1,48 @@
+#include "test.h"
+
+#include <iostream>
+
+bool CTest_Registry::Register(const char* name, void (*func)()) {
+	mCases.push_back({ name, func });
+	return true;
+}
+
+void CTest_Registry::Fail(const char* file, int line, std::string_view message) {
+	mFailures++;
+	std::cerr << "  " << file << ":" << line << ": check failed: " << message << std::endl;
+}
+
+void CTest_Registry::Set_Work_Directory(const std::filesystem::path& path) {
+	mWork_Directory = path;
+}
+
+std::filesystem::path CTest_Registry::Get_Work_Path(std::string_view name) const {
+	return mWork_Directory / name;
+}
+
+size_t CTest_Registry::Run(std::string_view filter) {
+
+	size_t failed = 0;
+	size_t run = 0;
+
+	for (auto& tc : mCases) {
+		if (!filter.empty() && std::string_view(tc.name).find(filter) == std::string_view::npos) {
+			continue;
+		}
+
+		std::cerr << "Running " << tc.name << "..." << std::endl;
+
+		mFailures = 0;
+		tc.func();
+		run++;
+
+		if (mFailures > 0) {
+			std::cerr << "FAILED " << tc.name << " (" << mFailures << " failed checks)" << std::endl;
+			failed++;
+		}
+	}
+
+	std::cerr << (run - failed) << " of " << run << " test cases passed" << std::endl;
+
+	return failed;
+}
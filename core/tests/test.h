@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+/*
+ * Registered test case
+ */
+struct TTest_Case {
+	const char* name;		// case name (also used to select cases from the command line)
+	void (*func)();			// case body
+};
+
+/*
+ * Test registry - cases register themselves at static initialization, failed checks are reported to the running case
+ */
+class CTest_Registry {
+	private:
+		// all registered cases in registration order
+		std::vector<TTest_Case> mCases;
+		// number of failed checks in the running case
+		size_t mFailures = 0;
+		// directory for files created by the cases
+		std::filesystem::path mWork_Directory;
+
+		CTest_Registry() = default;
+
+	public:
+		// static singleton retrieving method
+		static CTest_Registry& Instance() {
+			static CTest_Registry gInstance;
+			return gInstance;
+		}
+
+		// registers a test case
+		bool Register(const char* name, void (*func)());
+		// reports a failed check of the running case
+		void Fail(const char* file, int line, std::string_view message);
+
+		// sets the directory for files created by the cases
+		void Set_Work_Directory(const std::filesystem::path& path);
+		// retrieves a path of given file in the work directory
+		std::filesystem::path Get_Work_Path(std::string_view name) const;
+
+		// runs all cases, whose name contains given filter; returns the number of failed cases
+		size_t Run(std::string_view filter);
+};
+
+#define sTests CTest_Registry::Instance()
+
+// defines and registers a test case
+#define TEST_CASE(name) \
+	static void Test_##name(); \
+	static const bool Test_Registered_##name = sTests.Register(#name, &Test_##name); \
+	static void Test_##name()
+
+// checks a condition; the case continues on failure
+#define CHECK(cond) \
+	do { if (!(cond)) { sTests.Fail(__FILE__, __LINE__, #cond); } } while (false)
+
+// checks a condition; the case ends on failure, as the following checks would make no sense
+#define REQUIRE(cond) \
+	do { if (!(cond)) { sTests.Fail(__FILE__, __LINE__, #cond); return; } } while (false)
@@ -0,0 +1,86 @@
+#include "test_controller.h"
+#include "test.h"
+
+#include <fstream>
+
+#include "config.h"
+
+#include <spdlog/spdlog.h>
+
+const char* Test_Input = R"(Config(version = 1, width = 160, height = 120, fps = 10, defaultbackground = RGB('#336633'))
+
+Scene(duration = 4s) {
+    base = Rectangle(x = 10, y = 10, width = 40, height = 30, fill = RGB('#669966'), stroke = RGB('#000000'), strokewidth = 2)
+    dot = Circle(x = 120, y = 90, r = 12, fill = RGB('#FFFF00'))
+
+    Wait(duration = 1s)
+    moving = Rectangle(x = 60, y = 40, width = 20, height = 20, fill = RGB('#996699'), rotate = 10)
+
+    moving.Animate(rotate = 60, duration = 2s, width = 60)
+    base.Animate(x = 80, duration = 1s)
+}
+)";
+
+bool CTest_Controller::Load(const std::string& name, const std::string& source, const std::vector<std::string>& options) {
+
+	// every test starts from scratch, as if it was a separate run of the application
+	Reset_Global_State();
+
+	const auto inputFile = sTests.Get_Work_Path(name + ".vdef");
+	const auto outputDir = sTests.Get_Work_Path(name);
+
+	std::error_code ec;
+	std::filesystem::remove_all(outputDir, ec);
+	std::filesystem::create_directories(outputDir, ec);
+	if (ec) {
+		spdlog::error("Cannot create output directory {}: {}", outputDir.string(), ec.message());
+		return false;
+	}
+
+	{
+		std::ofstream out(inputFile, std::ios::out | std::ios::binary);
+		out << source;
+		if (!out) {
+			spdlog::error("Cannot write test input {}", inputFile.string());
+			return false;
+		}
+	}
+
+	// ffmpeg is not a part of the tests, so it must not be started alongside the rendering
+	std::vector<std::string> argv = { "VidGenX_tests", "--stitch-after" };
+	argv.insert(argv.end(), options.begin(), options.end());
+	argv.push_back(inputFile.string());
+	argv.push_back(outputDir.string());
+
+	return Initialize(argv) == 0 && Parse_Input_Files() && Parse_Blocks();
+}
+
+bool CTest_Controller::Render() {
+	return Render_Scenes();
+}
+
+CFrame_Renderer::CFrame_Renderer()
+	: mBuffer(static_cast<int>(sConfig.Get_Width()), static_cast<int>(sConfig.Get_Height())), mEncoder(CFrame_Encoder::Create({ NFrame_Format::Raw })) {
+	//
+}
+
+std::vector<uint8_t> CFrame_Renderer::Render(CScene& scene) {
+
+	CFrame_Snapshot snapshot(scene.Get_Current_Frame());
+	scene.Render_Frame(snapshot);
+
+	// the buffer holds whatever frame was rendered before, so the damage recorded by the scene does not apply
+	CDamage_Region full(static_cast<int>(sConfig.Get_Width()), static_cast<int>(sConfig.Get_Height()));
+	full.Set_Full();
+	snapshot.Set_Damage(full);
+
+	snapshot.Rasterize(mBuffer.Get_Context());
+	mBuffer.Sync();
+
+	std::vector<uint8_t> pixels;
+	if (!mEncoder->Encode(mBuffer.Get_Image(), pixels)) {
+		pixels.clear();
+	}
+
+	return pixels;
+}
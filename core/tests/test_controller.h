@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "controller.h"
+#include "render/frame_pool.h"
+#include "render/frame_encoder.h"
+
+/*
+ * Test controller - builds the scenes of an inline input, so the tests may step and render them directly
+ */
+class CTest_Controller : public CController {
+	public:
+		// writes given source to the work directory and parses it with given extra command line options
+		bool Load(const std::string& name, const std::string& source, const std::vector<std::string>& options = {});
+
+		// renders the scenes through the pipeline, as the application does
+		bool Render();
+
+		using CController::Get_Scenes;
+		using CController::Get_Output_Directory;
+};
+
+/*
+ * Renders frames of a scene one by one on the calling thread, always redrawing the whole frame
+ */
+class CFrame_Renderer {
+	private:
+		// buffer the frames are rasterized to
+		CFrame_Buffer mBuffer;
+		// encoder retrieving the pixels of the buffer
+		std::unique_ptr<CFrame_Encoder> mEncoder;
+
+	public:
+		CFrame_Renderer();
+
+		// records and rasterizes the current frame of the scene; retrieves its pixels in the memory layout of the renderer
+		std::vector<uint8_t> Render(CScene& scene);
+};
+
+// input used by the tests: a static object, a wait and two animations, one of them applied to an object drawn before it
+extern const char* Test_Input;